@@ -2,12 +2,37 @@
 
 #include "act-iter.h"
 
+#include "coord.h"
 #include "env.h"
 #include "losglobal.h"
 
+// Mark the monsters standing within LOS range of c. This looks at the
+// mgrid cells around c instead of every monster slot; the iterators
+// still visit the marked monsters in slot order and check each one
+// when they get to it.
+static void _find_monsters_near(const coord_def& c, near_monsters_t& nearby)
+{
+    nearby.reset();
+    if (!map_bounds(c))
+        return;
+
+    const int x1 = max(c.x - LOS_RADIUS, 0);
+    const int x2 = min(c.x + LOS_RADIUS, GXM - 1);
+    const int y1 = max(c.y - LOS_RADIUS, 0);
+    const int y2 = min(c.y + LOS_RADIUS, GYM - 1);
+    for (int x = x1; x <= x2; ++x)
+        for (int y = y1; y <= y2; ++y)
+        {
+            const unsigned short mi = env.mgrid[x][y];
+            if (mi < MAX_MONSTERS)
+                nearby.set(mi);
+        }
+}
+
 actor_near_iterator::actor_near_iterator(coord_def c, los_type los)
     : center(c), _los(los), viewer(nullptr), i(-1)
 {
+    _find_monsters_near(center, nearby);
     if (!valid(&you))
         advance();
 }
@@ -15,6 +40,7 @@ actor_near_iterator::actor_near_iterator(coord_def c, los_type los)
 actor_near_iterator::actor_near_iterator(const actor* a, los_type los)
     : center(a->pos()), _los(los), viewer(a), i(-1)
 {
+    _find_monsters_near(center, nearby);
     if (!valid(&you))
         advance();
 }
@@ -66,7 +92,7 @@ void actor_near_iterator::advance()
     do
          if (++i >= MAX_MONSTERS)
              return;
-    while (!valid(**this));
+    while (!nearby[i] || !valid(**this));
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -74,7 +100,8 @@ void actor_near_iterator::advance()
 monster_near_iterator::monster_near_iterator(coord_def c, los_type los)
     : center(c), _los(los), viewer(nullptr), i(0)
 {
-    if (!valid(&menv[0]))
+    _find_monsters_near(center, nearby);
+    if (!nearby[0] || !valid(&menv[0]))
         advance();
     begin_point = i;
 }
@@ -82,7 +109,8 @@ monster_near_iterator::monster_near_iterator(coord_def c, los_type los)
 monster_near_iterator::monster_near_iterator(const actor *a, los_type los)
     : center(a->pos()), _los(los), viewer(a), i(0)
 {
-    if (!valid(&menv[0]))
+    _find_monsters_near(center, nearby);
+    if (!nearby[0] || !valid(&menv[0]))
         advance();
     begin_point = i;
 }
@@ -156,7 +184,7 @@ void monster_near_iterator::advance()
     do
          if (++i >= MAX_MONSTERS)
              return;
-    while (!valid(**this));
+    while (!nearby[i] || !valid(**this));
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -5,8 +5,12 @@
 
 #pragma once
 
+#include "bitary.h"
 #include "los-type.h"
 
+// The monsters that might be in LOS of a point, found via mgrid.
+typedef FixedBitVector<MAX_MONSTERS> near_monsters_t;
+
 class actor_near_iterator
 {
 public:
@@ -24,6 +28,7 @@ protected:
     los_type _los;
     const actor* viewer;
     int i;
+    near_monsters_t nearby;
 
     bool valid(const actor* a) const;
     void advance();
@@ -51,6 +56,7 @@ protected:
     const actor* viewer;
     int i;
     int begin_point;
+    near_monsters_t nearby;
 
     bool valid(const monster* a) const;
     void advance();
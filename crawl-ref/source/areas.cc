@@ -60,6 +60,56 @@ static propgrid_t _agrid;
 static bool _agrid_valid = false;
 static bool no_areas = false;
 
+// The areas of actors are kept track of per actor, so that when one of
+// them moves only its own cells are recomputed. Each cell counts how
+// many actors give it each property. Anything that may change LOS or
+// terrain goes through invalidate_agrid(), which forces a full rebuild.
+static const areaprop _actor_props[] =
+{
+    areaprop::silence, areaprop::halo, areaprop::liquid,
+    areaprop::actual_liquid, areaprop::umbra,
+};
+#define NUM_ACTOR_PROPS ARRAYSZ(_actor_props)
+
+typedef FixedArray<uint16_t, GXM, GYM> propcount_t;
+static propcount_t _agrid_counts[NUM_ACTOR_PROPS];
+
+struct area_source
+{
+    coord_def pos;
+    int silence = -1;
+    int halo = -1;
+    int liquid = -1;
+    int umbra = -1;
+    // The update in which this actor was last seen with an area.
+    unsigned int update = 0;
+    vector<pair<coord_def, areaprops>> cells;
+
+    area_source() { }
+    explicit area_source(const actor *a)
+        : pos(a->pos()), silence(a->silence_radius()),
+          halo(a->halo_radius()), liquid(a->liquefying_radius()),
+          umbra(a->umbra_radius())
+    {
+    }
+
+    bool has_area() const
+    {
+        return silence >= 0 || halo >= 0 || liquid >= 0 || umbra >= 0;
+    }
+
+    bool same_area(const area_source &other) const
+    {
+        return pos == other.pos && silence == other.silence
+               && halo == other.halo && liquid == other.liquid
+               && umbra == other.umbra;
+    }
+};
+
+static map<mid_t, area_source> _agrid_sources;
+static unsigned int _agrid_update = 0;
+static bool _agrid_rebuild = true;
+
 static void _set_agrid_flag(const coord_def& p, areaprop f)
 {
     _agrid(p) |= f;
@@ -73,6 +123,7 @@ static bool _check_agrid_flag(const coord_def& p, areaprop f)
 void invalidate_agrid(bool recheck_new)
 {
     _agrid_valid = false;
+    _agrid_rebuild = true;
     if (recheck_new)
         no_areas = false;
 }
@@ -85,63 +136,137 @@ void areas_actor_moved(const actor* act, const coord_def& oldpos)
          || act->liquefying_radius() > -1 || act->umbra_radius() > -1))
     {
         // Not necessarily new, but certainly potentially interesting.
-        invalidate_agrid(true);
+        // Only the areas of actors that changed need to be redone.
+        if (you.entering_level)
+            invalidate_agrid(true);
+        else
+        {
+            _agrid_valid = false;
+            no_areas = false;
+        }
     }
 }
 
-static void _actor_areas(actor *a)
+// Cells given properties by something other than an actor, in the last
+// update; those are redone every time.
+static vector<coord_def> _agrid_other_cells;
+
+static void _add_source_cells(const area_source &src, int delta)
 {
-    int r;
+    for (const auto &cell : src.cells)
+        for (unsigned int i = 0; i < NUM_ACTOR_PROPS; ++i)
+        {
+            if (!(cell.second & _actor_props[i]))
+                continue;
+
+            // The grid has the property while any actor gives it.
+            uint16_t &count = _agrid_counts[i](cell.first);
+            count += delta;
+            if (delta > 0 && count == 1)
+                _agrid(cell.first) |= _actor_props[i];
+            else if (delta < 0 && count == 0)
+                _agrid(cell.first) &= ~_actor_props[i];
+        }
+}
 
-    if ((r = a->silence_radius()) >= 0)
-    {
-        _agrid_centres.emplace_back(area_centre_type::silence, a->pos(), r);
+static areaprops _actor_area_props(const coord_def &p)
+{
+    areaprops props;
+    for (unsigned int i = 0; i < NUM_ACTOR_PROPS; ++i)
+        if (_agrid_counts[i](p))
+            props |= _actor_props[i];
+    return props;
+}
 
-        for (radius_iterator ri(a->pos(), r, C_SQUARE); ri; ++ri)
-            _set_agrid_flag(*ri, areaprop::silence);
-        no_areas = false;
-    }
+static void _set_other_agrid_flag(const coord_def& p, areaprop f)
+{
+    _set_agrid_flag(p, f);
+    _agrid_other_cells.push_back(p);
+}
 
-    if ((r = a->halo_radius()) >= 0)
-    {
-        _agrid_centres.emplace_back(area_centre_type::halo, a->pos(), r);
+static void _find_source_cells(area_source &src)
+{
+    src.cells.clear();
 
-        for (radius_iterator ri(a->pos(), r, C_SQUARE, LOS_DEFAULT); ri; ++ri)
-            _set_agrid_flag(*ri, areaprop::halo);
-        no_areas = false;
-    }
+    if (src.silence >= 0)
+        for (radius_iterator ri(src.pos, src.silence, C_SQUARE); ri; ++ri)
+            src.cells.emplace_back(*ri, areaprop::silence);
 
-    if ((r = a->liquefying_radius()) >= 0)
+    if (src.halo >= 0)
     {
-        _agrid_centres.emplace_back(area_centre_type::liquid, a->pos(), r);
+        for (radius_iterator ri(src.pos, src.halo, C_SQUARE, LOS_DEFAULT);
+             ri; ++ri)
+        {
+            src.cells.emplace_back(*ri, areaprop::halo);
+        }
+    }
 
-        for (radius_iterator ri(a->pos(), r, C_SQUARE, LOS_SOLID); ri; ++ri)
+    if (src.liquid >= 0)
+    {
+        for (radius_iterator ri(src.pos, src.liquid, C_SQUARE, LOS_SOLID);
+             ri; ++ri)
         {
             dungeon_feature_type f = grd(*ri);
 
-            _set_agrid_flag(*ri, areaprop::liquid);
-
+            areaprops props = areaprop::liquid;
             if (feat_has_solid_floor(f) && !feat_is_water(f))
-                _set_agrid_flag(*ri, areaprop::actual_liquid);
+                props |= areaprop::actual_liquid;
+            src.cells.emplace_back(*ri, props);
         }
-        no_areas = false;
     }
 
-    if ((r = a->umbra_radius()) >= 0)
+    if (src.umbra >= 0)
     {
-        _agrid_centres.emplace_back(area_centre_type::umbra, a->pos(), r);
+        for (radius_iterator ri(src.pos, src.umbra, C_SQUARE, LOS_DEFAULT);
+             ri; ++ri)
+        {
+            src.cells.emplace_back(*ri, areaprop::umbra);
+        }
+    }
+}
 
-        for (radius_iterator ri(a->pos(), r, C_SQUARE, LOS_DEFAULT); ri; ++ri)
-            _set_agrid_flag(*ri, areaprop::umbra);
-        no_areas = false;
+static void _actor_areas(actor *a)
+{
+    const area_source cur(a);
+    if (!cur.has_area())
+        return;
+
+    area_source &src = _agrid_sources[a->mid];
+    if (!src.has_area() || !src.same_area(cur))
+    {
+        _add_source_cells(src, -1);
+        src = cur;
+        _find_source_cells(src);
+        _add_source_cells(src, 1);
     }
+    src.update = _agrid_update;
+
+    if (cur.silence >= 0)
+    {
+        _agrid_centres.emplace_back(area_centre_type::silence, cur.pos,
+                                    cur.silence);
+    }
+    if (cur.halo >= 0)
+        _agrid_centres.emplace_back(area_centre_type::halo, cur.pos, cur.halo);
+    if (cur.liquid >= 0)
+    {
+        _agrid_centres.emplace_back(area_centre_type::liquid, cur.pos,
+                                    cur.liquid);
+    }
+    if (cur.umbra >= 0)
+    {
+        _agrid_centres.emplace_back(area_centre_type::umbra, cur.pos,
+                                    cur.umbra);
+    }
+    no_areas = false;
 }
 
 /**
  * Update the area grid cache.
  *
  * Updates the _agrid FixedArray of grid information flags using the
- * areaprop types.
+ * areaprop types. Unless a full rebuild was asked for, only the areas of
+ * actors that moved, appeared, disappeared or changed radius are redone.
  */
 static void _update_agrid()
 {
@@ -151,8 +276,26 @@ static void _update_agrid()
         return;
     }
 
-    _agrid.init(areaprops());
+    if (_agrid_rebuild)
+    {
+        _agrid_sources.clear();
+        for (propcount_t &counts : _agrid_counts)
+            counts.init(0);
+        _agrid.init(areaprops());
+        _agrid_other_cells.clear();
+        _agrid_rebuild = false;
+    }
+    else
+    {
+        // Leave only what actors give, so that their cells can be updated
+        // on their own.
+        for (const coord_def &p : _agrid_other_cells)
+            _agrid(p) = _actor_area_props(p);
+        _agrid_other_cells.clear();
+    }
+
     _agrid_centres.clear();
+    ++_agrid_update;
 
     no_areas = true;
 
@@ -160,12 +303,24 @@ static void _update_agrid()
     for (monster_iterator mi; mi; ++mi)
         _actor_areas(*mi);
 
+    // Drop the areas of actors that are gone or no longer have any.
+    for (auto it = _agrid_sources.begin(); it != _agrid_sources.end();)
+    {
+        if (it->second.update != _agrid_update)
+        {
+            _add_source_cells(it->second, -1);
+            it = _agrid_sources.erase(it);
+        }
+        else
+            ++it;
+    }
+
     if (player_has_orb() && !you.pos().origin())
     {
         const int r = 2;
         _agrid_centres.emplace_back(area_centre_type::orb, you.pos(), r);
         for (radius_iterator ri(you.pos(), r, C_SQUARE, LOS_DEFAULT); ri; ++ri)
-            _set_agrid_flag(*ri, areaprop::orb);
+            _set_other_agrid_flag(*ri, areaprop::orb);
         no_areas = false;
     }
 
@@ -177,7 +332,7 @@ static void _update_agrid()
              ri; ++ri)
         {
             if (cell_see_cell(you.pos(), *ri, LOS_DEFAULT))
-                _set_agrid_flag(*ri, areaprop::quad);
+                _set_other_agrid_flag(*ri, areaprop::quad);
         }
         no_areas = false;
     }
@@ -191,7 +346,7 @@ static void _update_agrid()
              ri; ++ri)
         {
             if (cell_see_cell(you.pos(), *ri, LOS_DEFAULT))
-                _set_agrid_flag(*ri, areaprop::disjunction);
+                _set_other_agrid_flag(*ri, areaprop::disjunction);
         }
         no_areas = false;
     }
@@ -199,7 +354,7 @@ static void _update_agrid()
     if (!env.sunlight.empty())
     {
         for (const auto &entry : env.sunlight)
-            _set_agrid_flag(entry.first, areaprop::halo);
+            _set_other_agrid_flag(entry.first, areaprop::halo);
         no_areas = false;
     }
 
@@ -1034,21 +1034,49 @@ void bolt::affect_cell()
         affect_ground();
 }
 
-static void _undo_tracer(bolt &orig, bolt &copy)
-{
-    // FIXME: we should have a better idea of what gets changed!
-    orig.target           = copy.target;
-    orig.source           = copy.source;
-    orig.aimed_at_spot    = copy.aimed_at_spot;
-    orig.extra_range_used = copy.extra_range_used;
-    orig.auto_hit         = copy.auto_hit;
-    orig.ray              = copy.ray;
-    orig.colour           = copy.colour;
-    orig.flavour          = copy.flavour;
-    orig.real_flavour     = copy.real_flavour;
-    orig.bounces          = copy.bounces;
-    orig.bounce_pos       = copy.bounce_pos;
-}
+// The parts of a bolt that firing a tracer may change and that the caller
+// expects to be left alone. Saving just these avoids copying the whole
+// bolt (with its strings and path) every time a tracer is fired.
+struct tracer_state
+{
+    coord_def target;
+    coord_def source;
+    bool aimed_at_spot;
+    int extra_range_used;
+    bool auto_hit;
+    ray_def ray;
+    colour_t colour;
+    beam_type flavour;
+    beam_type real_flavour;
+    int bounces;
+    coord_def bounce_pos;
+
+    explicit tracer_state(const bolt &beam)
+        : target(beam.target), source(beam.source),
+          aimed_at_spot(beam.aimed_at_spot),
+          extra_range_used(beam.extra_range_used), auto_hit(beam.auto_hit),
+          ray(beam.ray), colour(beam.colour), flavour(beam.flavour),
+          real_flavour(beam.real_flavour), bounces(beam.bounces),
+          bounce_pos(beam.bounce_pos)
+    {
+    }
+
+    void restore(bolt &beam) const
+    {
+        // FIXME: we should have a better idea of what gets changed!
+        beam.target           = target;
+        beam.source           = source;
+        beam.aimed_at_spot    = aimed_at_spot;
+        beam.extra_range_used = extra_range_used;
+        beam.auto_hit         = auto_hit;
+        beam.ray              = ray;
+        beam.colour           = colour;
+        beam.flavour          = flavour;
+        beam.real_flavour     = real_flavour;
+        beam.bounces          = bounces;
+        beam.bounce_pos       = bounce_pos;
+    }
+};
 
 // This saves some important things before calling fire().
 void bolt::fire()
@@ -1060,19 +1088,17 @@ void bolt::fire()
 
     if (is_tracer)
     {
-        bolt boltcopy = *this;
-        if (special_explosion != nullptr)
-            boltcopy.special_explosion = new bolt(*special_explosion);
-
-        do_fire();
-
+        const tracer_state saved(*this);
         if (special_explosion != nullptr)
         {
-            _undo_tracer(*special_explosion, *boltcopy.special_explosion);
-            delete boltcopy.special_explosion;
+            const tracer_state saved_explosion(*special_explosion);
+            do_fire();
+            saved_explosion.restore(*special_explosion);
         }
+        else
+            do_fire();
 
-        _undo_tracer(*this, boltcopy);
+        saved.restore(*this);
     }
     else
         do_fire();
@@ -5887,6 +5913,16 @@ void bolt::refine_for_explosion()
     // gets burned by it anyway.  :)
     msg_generated = true;
 
+    if (origin_spell == SPELL_ORB_OF_ELECTRICITY)
+    {
+        colour     = LIGHTCYAN;
+        ex_size    = 2;
+    }
+
+    // Tracers print nothing, so don't bother building the messages.
+    if (is_tracer)
+        return;
+
     if (item != nullptr)
     {
         seeMsg  = "The " + item->name(DESC_PLAIN, false, false, false)
@@ -5909,13 +5945,7 @@ void bolt::refine_for_explosion()
         }
     }
 
-    if (origin_spell == SPELL_ORB_OF_ELECTRICITY)
-    {
-        colour     = LIGHTCYAN;
-        ex_size    = 2;
-    }
-
-    if (!is_tracer && !seeMsg.empty() && !hearMsg.empty())
+    if (!seeMsg.empty() && !hearMsg.empty())
     {
         heard = player_can_hear(target);
         // Check for see/hear/no msg.
@@ -186,4 +186,21 @@ public:
         data &= x.data;
         return *this;
     }
+
+    inline FixedBitArray<SIZEX, SIZEY> operator&(const FixedBitArray<SIZEX, SIZEY>&x) const
+    {
+        FixedBitArray<SIZEX, SIZEY> result(*this);
+        result &= x;
+        return result;
+    }
+
+    inline unsigned int count() const
+    {
+        return data.count();
+    }
+
+    inline bool any() const
+    {
+        return data.any();
+    }
 };
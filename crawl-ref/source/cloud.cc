@@ -39,9 +39,72 @@
 #include "tiledef-main.h"
 #include "unwind.h"
 
+cloud_store::cloud_store()
+{
+    clouds.reserve(GXM * GYM);
+    index.init(-1);
+}
+
+cloud_store& cloud_store::operator=(const cloud_store& other)
+{
+    // Keep our reserved storage.
+    clouds.assign(other.clouds.begin(), other.clouds.end());
+    index = other.index;
+    return *this;
+}
+
+cloud_struct* cloud_store::find(const coord_def& p)
+{
+    if (!map_bounds(p) || index(p) < 0)
+        return nullptr;
+    return &clouds[index(p)];
+}
+
+const cloud_struct* cloud_store::find(const coord_def& p) const
+{
+    if (!map_bounds(p) || index(p) < 0)
+        return nullptr;
+    return &clouds[index(p)];
+}
+
+cloud_struct& cloud_store::operator[](const coord_def& p)
+{
+    ASSERT(map_bounds(p));
+    if (index(p) < 0)
+    {
+        index(p) = clouds.size();
+        clouds.emplace_back();
+        clouds.back().pos = p;
+    }
+    return clouds[index(p)];
+}
+
+void cloud_store::erase(const coord_def& p)
+{
+    if (!map_bounds(p) || index(p) < 0)
+        return;
+
+    const int i = index(p);
+    const int last = clouds.size() - 1;
+    if (i != last)
+    {
+        ASSERT(index(clouds[last].pos) == last);
+        clouds[i] = clouds[last];
+        index(clouds[i].pos) = i;
+    }
+    clouds.pop_back();
+    index(p) = -1;
+}
+
+void cloud_store::clear()
+{
+    clouds.clear();
+    index.init(-1);
+}
+
 cloud_struct* cloud_at(coord_def pos)
 {
-    return map_find(env.cloud, pos);
+    return env.cloud.find(pos);
 }
 
 /// damage = base + random2avg(random, random/15 + 1)
@@ -564,14 +627,19 @@ static void _handle_spectral_cloud(const cloud_struct& cloud)
 void manage_clouds()
 {
     // We can't iterate over env.cloud directly because _dissipate_cloud
-    // will remove this cloud and invalidate our iterator.
-    vector<cloud_struct *> cloud_ptrs;
-    for (auto& entry : env.cloud)
-        cloud_ptrs.push_back(&entry.second);
+    // will remove this cloud, moving another one into its place. Go in
+    // order of position, so that which cloud gets to act first doesn't
+    // depend on the order they were added and removed in.
+    vector<coord_def> cloud_locs;
+    for (const cloud_struct& cloud : env.cloud)
+        cloud_locs.push_back(cloud.pos);
+    sort(cloud_locs.begin(), cloud_locs.end());
 
-    for (auto ptr : cloud_ptrs)
+    for (auto pos : cloud_locs)
     {
-        cloud_struct& cloud = *ptr;
+        if (!cloud_at(pos))
+            continue;
+        cloud_struct& cloud = *cloud_at(pos);
 
 #ifdef ASSERTS
         if (cell_is_solid(cloud.pos))
@@ -653,8 +721,8 @@ void delete_all_clouds()
     // We can't iterate over env.cloud directly because delete_cloud
     // will remove this cloud and invalidate our iterator.
     vector<coord_def> cloud_locs;
-    for (auto& entry : env.cloud)
-        cloud_locs.push_back(entry.first);
+    for (const cloud_struct& cloud : env.cloud)
+        cloud_locs.push_back(cloud.pos);
 
     for (auto pos : cloud_locs)
         delete_cloud(pos);
@@ -1718,9 +1786,9 @@ void remove_tornado_clouds(mid_t whose)
     // We can't iterate over env.cloud directly because delete_cloud
     // will remove this cloud and invalidate our iterator.
     vector<coord_def> tornados;
-    for (auto& entry : env.cloud)
-        if (entry.second.type == CLOUD_TORNADO && entry.second.source == whose)
-            tornados.push_back(entry.first);
+    for (const cloud_struct& cloud : env.cloud)
+        if (cloud.type == CLOUD_TORNADO && cloud.source == whose)
+            tornados.push_back(cloud.pos);
 
     for (auto pos : tornados)
         delete_cloud(pos);
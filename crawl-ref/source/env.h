@@ -71,7 +71,7 @@ struct crawl_environment
     tile_flavour tile_default;
     vector<string> tile_names;
 
-    map<coord_def, cloud_struct> cloud;
+    cloud_store cloud;
 
     map<coord_def, shop_struct> shop; // shop list
     map<coord_def, trap_def> trap; // trap list
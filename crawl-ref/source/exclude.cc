@@ -195,7 +195,7 @@ exclude_set::exclude_set()
 void exclude_set::clear()
 {
     exclude_roots.clear();
-    exclude_points.clear();
+    exclude_points.reset();
 }
 
 void exclude_set::erase(const coord_def &p)
@@ -229,28 +229,30 @@ void exclude_set::add_exclude_points(travel_exclude& ex)
 {
     if (ex.radius == 0)
     {
-        exclude_points.insert(ex.pos);
+        exclude_points.set(ex.pos);
         return;
     }
 
+    // The LOS of an exclusion only needs recomputing if something in its
+    // range changed since; see update_exclusion_los().
     if (!ex.uptodate)
         ex.set_los();
-    else
-        ex.los.update();
 
     for (radius_iterator ri(ex.pos, ex.radius, C_SQUARE); ri; ++ri)
         if (ex.affects(*ri))
-            exclude_points.insert(*ri);
+            exclude_points.set(*ri);
 }
 
-void exclude_set::update_excluded_points(bool recompute_los)
+// Bring the exclusions whose LOS was invalidated up to date, and rebuild
+// the excluded points. The others keep their LOS.
+void exclude_set::update_excluded_points()
 {
     for (iterator it = exclude_roots.begin(); it != exclude_roots.end(); ++it)
     {
         travel_exclude &ex = it->second;
         if (!ex.uptodate)
         {
-            recompute_excluded_points(recompute_los);
+            recompute_excluded_points();
             return;
         }
     }
@@ -258,7 +260,7 @@ void exclude_set::update_excluded_points(bool recompute_los)
 
 void exclude_set::recompute_excluded_points(bool recompute_los)
 {
-    exclude_points.clear();
+    exclude_points.reset();
     for (iterator it = exclude_roots.begin(); it != exclude_roots.end(); ++it)
     {
         travel_exclude &ex = it->second;
@@ -270,7 +272,7 @@ void exclude_set::recompute_excluded_points(bool recompute_los)
 
 bool exclude_set::is_excluded(const coord_def &p) const
 {
-    return exclude_points.count(p);
+    return map_bounds(p) && exclude_points(p);
 }
 
 bool exclude_set::is_exclude_root(const coord_def &p) const
@@ -343,7 +345,7 @@ void update_exclusion_los(vector<coord_def> changed)
     for (coord_def c : changed)
         _mark_excludes_non_updated(c);
 
-    curr_excludes.update_excluded_points(true);
+    curr_excludes.update_excluded_points();
 }
 
 bool is_excluded(const coord_def &p, const exclude_set &exc)
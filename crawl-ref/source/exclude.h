@@ -1,5 +1,6 @@
 #pragma once
 
+#include "bitary.h"
 #include "los-def.h"
 
 void set_auto_exclude(const monster* mon);
@@ -65,7 +66,7 @@ public:
                      string desc = "",
                      bool vaultexcl = false);
 
-    void update_excluded_points(bool recompute_los = false);
+    void update_excluded_points();
     void recompute_excluded_points(bool recompute_los = false);
 
     travel_exclude* get_exclude_root(const coord_def &p);
@@ -84,10 +85,10 @@ public:
     iterator  end();
 
 private:
-    typedef set<coord_def> exclset;
-
     exclmap exclude_roots;
-    exclset exclude_points;
+    // All cells covered by some exclusion. Kept alongside the roots,
+    // including in the travel cache for other levels.
+    FixedBitArray<GXM, GYM> exclude_points;
 
 private:
     void add_exclude_points(travel_exclude& ex);
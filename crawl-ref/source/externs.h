@@ -353,6 +353,45 @@ struct cloud_struct
     static killer_type   whose_to_killer(kill_category whose);
 };
 
+/**
+ * The clouds on a level, stored densely for quick iteration, with a grid
+ * of indices into the store for lookup by position.
+ *
+ * Storage for a cloud in every cell is reserved up front, so placing a
+ * cloud never moves the others. Removing a cloud moves the last cloud into
+ * its slot, so the iteration order is not stable, and only pointers to
+ * clouds other than the last one survive a removal.
+ *
+ * Copies only hold their clouds, without the reserved storage; they are
+ * meant to be assigned back to a store, which keeps its own.
+ */
+class cloud_store
+{
+public:
+    cloud_store();
+    cloud_store(const cloud_store& other) = default;
+    cloud_store& operator=(const cloud_store& other);
+
+    cloud_struct* find(const coord_def& p);
+    const cloud_struct* find(const coord_def& p) const;
+    // Like map::operator[], adds an empty cloud at p if there is none.
+    cloud_struct& operator[](const coord_def& p);
+    void erase(const coord_def& p);
+    void clear();
+
+    size_t size() const { return clouds.size(); }
+    bool empty() const { return clouds.empty(); }
+
+    vector<cloud_struct>::iterator begin() { return clouds.begin(); }
+    vector<cloud_struct>::iterator end() { return clouds.end(); }
+    vector<cloud_struct>::const_iterator begin() const { return clouds.begin(); }
+    vector<cloud_struct>::const_iterator end() const { return clouds.end(); }
+
+private:
+    vector<cloud_struct> clouds;
+    FixedArray<short, GXM, GYM> index; // into clouds, or -1
+};
+
 struct shop_struct
 {
     coord_def           pos;
@@ -122,6 +122,26 @@ LUAFN(debug_los_changed)
     return 0;
 }
 
+// Usage: debug.los_engine(["rays"|"cells"])
+// Returns the name of the current LOS engine, switching to the given one
+// if specified.
+LUAFN(debug_los_engine)
+{
+    const bool cells = get_los_engine() == LOS_ENGINE_CELLS;
+    if (lua_isstring(ls, 1))
+    {
+        const string engine = lua_tostring(ls, 1);
+        if (engine == "cells")
+            set_los_engine(LOS_ENGINE_CELLS);
+        else if (engine == "rays")
+            set_los_engine(LOS_ENGINE_RAYS);
+        else
+            luaL_argerror(ls, 1, ("unknown LOS engine: " + engine).c_str());
+    }
+    lua_pushstring(ls, cells ? "cells" : "rays");
+    return 1;
+}
+
 LUAFN(debug_dump_map)
 {
     const int pos = lua_isuserdata(ls, 1) ? 2 : 1;
@@ -441,6 +461,7 @@ const struct luaL_reg debug_dlib[] =
 { "generate_level", debug_generate_level },
 { "reveal_mimics", debug_reveal_mimics },
 { "los_changed", debug_los_changed },
+{ "los_engine", debug_los_engine },
 { "dump_map", debug_dump_map },
 { "vault_names", debug_vault_names },
 { "test_explore", _debug_test_explore },
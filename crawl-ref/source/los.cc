@@ -33,7 +33,8 @@
  * At first use, the LOS code makes some precomputations,
  * filling a list of all relevant rays in one quadrant,
  * and filling data structures that allow calculating LOS
- * in a quadrant without checking each ray.
+ * in a quadrant without checking each ray. The list of rays
+ * is normally generated at build time by util/gen-los-rays.py.
  *
  * The code provides functions for filling LOS information
  * around a given center efficiently, and for querying rays
@@ -52,9 +53,13 @@
 #include "coordit.h"
 #include "env.h"
 #include "losglobal.h"
+#include "los-rays.h"
+#include "mon-pathfind.h"
 
 // These determine what rays are cast in the precomputation,
-// and affect start-up time significantly.
+// and affect start-up time significantly. They have to match
+// util/gen-los-rays.py, which does the precomputation at build
+// time; otherwise it is done at first use.
 // XXX: Argue that these values are sufficient.
 #define LOS_MAX_ANGLE (2*LOS_MAX_RANGE-2)
 #define LOS_INTERCEPT_MULT (2)
@@ -62,7 +67,8 @@
 // These store all unique (in terms of footprint) full rays.
 // The footprint of ray=fullray[i] consists of ray.length cells,
 // stored in ray_coords[ray.start..ray.length-1].
-// These are filled during precomputation (_register_ray).
+// These are filled during precomputation (_register_ray),
+// or loaded from los-rays.h (_load_ray_tables).
 // XXX: fullrays is not needed anymore after precomputation.
 struct los_ray;
 static vector<los_ray> fullrays;
@@ -89,6 +95,16 @@ static FixedArray<vector<cellray>, LOS_MAX_RANGE+1, LOS_MAX_RANGE+1> min_cellray
 static bit_vector *dead_rays     = nullptr;
 static bit_vector *smoke_rays    = nullptr;
 
+// The same information, transposed for the bitboard engine: for each
+// minimal cellray i, cellray_cells[i] has those cells p set that block
+// the cellray. The minimal cellrays are sorted by end cell, and those
+// ending in p are cellray_cells[cellray_range(p).first..second-1].
+typedef FixedBitArray<LOS_MAX_RANGE+1, LOS_MAX_RANGE+1> quadrant_mask;
+static vector<quadrant_mask> cellray_cells;
+static FixedArray<pair<int, int>, LOS_MAX_RANGE+1, LOS_MAX_RANGE+1> cellray_range;
+
+static los_engine_type los_engine = LOS_ENGINE_CELLS;
+
 class quadrant_iterator : public rectangle_iterator
 {
 public:
@@ -125,6 +141,17 @@ int get_los_radius()
     return los_radius;
 }
 
+void set_los_engine(los_engine_type engine)
+{
+    los_engine = engine;
+    los_changed();
+}
+
+los_engine_type get_los_engine()
+{
+    return los_engine;
+}
+
 bool double_is_zero(const double x)
 {
     return x > -EPSILON_VALUE && x < EPSILON_VALUE;
@@ -304,9 +331,8 @@ static compare_type _compare_cellrays(const cellray& a, const cellray& b)
 }
 
 // Determine all minimal cellrays.
-// They're stored globally by target in min_cellrays,
-// and returned as a list of indices into ray_coords.
-static vector<int> _find_minimal_cellrays()
+// They're stored globally by target in min_cellrays.
+static void _find_minimal_cellrays()
 {
     FixedArray<list<cellray>, LOS_MAX_RANGE+1, LOS_MAX_RANGE+1> minima;
     list<cellray>::iterator min_it;
@@ -349,20 +375,15 @@ static vector<int> _find_minimal_cellrays()
         }
     }
 
-    vector<int> result;
     for (quadrant_iterator qi; qi; ++qi)
     {
         list<cellray>& min = minima(*qi);
+        // Calculate imbalance and slope difference for sorting.
         for (min_it = min.begin(); min_it != min.end(); ++min_it)
-        {
-            // Calculate imbalance and slope difference for sorting.
             min_it->calc_params();
-            result.push_back(min_it->index());
-        }
         min.sort(_is_better);
         min_cellrays(*qi) = vector<cellray>(min.begin(), min.end());
     }
-    return result;
 }
 
 // Create and register the ray defined by the arguments.
@@ -383,55 +404,40 @@ static void _register_ray(geom::ray r)
 
 static void _create_blockrays()
 {
-    // First, we calculate blocking information for all cell rays.
-    // Cellrays are numbered according to the index of their end
-    // cell in ray_coords.
-    const int n_cellrays = ray_coords.size();
-    blockrays_t all_blockrays;
+    // Number the minimal cellrays by end cell, in quadrant order.
+    int n_min_rays = 0;
     for (quadrant_iterator qi; qi; ++qi)
-        all_blockrays(*qi) = new bit_vector(n_cellrays);
-
-    for (los_ray ray : fullrays)
-    {
-        for (unsigned int i = 0; i < ray.length; ++i)
-        {
-            // Every cell is contained in (thus blocks)
-            // all following cellrays.
-            for (unsigned int j = i + 1; j < ray.length; ++j)
-                all_blockrays(ray[i])->set(ray.start + j);
-        }
-    }
-
-    // We've built the basic blockray array; now compress it, keeping
-    // only the nonduplicated cellrays.
+        n_min_rays += min_cellrays(*qi).size();
 
-    // Determine minimal cellrays and store their indices in ray_coords.
-    vector<int> min_indices = _find_minimal_cellrays();
-    const int n_min_rays    = min_indices.size();
+    for (quadrant_iterator qi; qi; ++qi)
+        blockrays(*qi) = new bit_vector(n_min_rays);
     cellray_ends.resize(n_min_rays);
-    for (int i = 0; i < n_min_rays; ++i)
-        cellray_ends[i] = ray_coords[min_indices[i]];
+    cellray_cells.resize(n_min_rays);
 
-    // Compress blockrays accordingly.
+    int i = 0;
     for (quadrant_iterator qi; qi; ++qi)
     {
-        blockrays(*qi) = new bit_vector(n_min_rays);
-        for (int i = 0; i < n_min_rays; ++i)
+        cellray_range(*qi).first = i;
+        for (cellray c : min_cellrays(*qi))
         {
-            blockrays(*qi)->set(i, all_blockrays(*qi)
-                                   ->get(min_indices[i]));
+            cellray_ends[i] = c.target();
+            // Every cell before the end blocks the cellray.
+            for (unsigned int j = 0; j < c.end; ++j)
+            {
+                blockrays(c[j])->set(i);
+                cellray_cells[i].set(c[j]);
+            }
+            ++i;
         }
+        cellray_range(*qi).second = i;
     }
 
-    // We can throw away all_blockrays now.
-    for (quadrant_iterator qi; qi; ++qi)
-        delete all_blockrays(*qi);
-
     dead_rays  = new bit_vector(n_min_rays);
     smoke_rays = new bit_vector(n_min_rays);
 
-    dprf("Cellrays: %d Fullrays: %u Minimal cellrays: %u",
-          n_cellrays, (unsigned int)fullrays.size(), n_min_rays);
+    dprf("Cellrays: %u Fullrays: %u Minimal cellrays: %d",
+          (unsigned int)ray_coords.size(), (unsigned int)fullrays.size(),
+          n_min_rays);
 }
 
 static int _gcd(int x, int y)
@@ -452,16 +458,11 @@ static bool _complexity_lt(const pair<int,int>& lhs, const pair<int,int>& rhs)
     return lhs.first * lhs.second < rhs.first * rhs.second;
 }
 
-// Cast all rays
-static void raycast()
+// Cast all rays and determine the minimal cellrays.
+static void _cast_rays()
 {
-    static bool done_raycast = false;
-    if (done_raycast)
-        return;
-
     // Creating all rays for first quadrant
     // We have a considerable amount of overkill.
-    done_raycast = true;
 
     // register perpendiculars FIRST, to make them top choice
     // when selecting beams
@@ -476,6 +477,8 @@ static void raycast()
 
     // Changing the order a bit. We want to order by the complexity
     // of the beam, which is log(x) + log(y) ~ xy.
+    // The sort is stable so that the choice among rays with the same
+    // footprint doesn't depend on the library (see gen-los-rays.py).
     vector<pair<int,int> > xyangles;
     for (int xangle = 1; xangle <= LOS_MAX_ANGLE; ++xangle)
         for (int yangle = 1; yangle <= LOS_MAX_ANGLE; ++yangle)
@@ -484,7 +487,7 @@ static void raycast()
                 xyangles.emplace_back(xangle, yangle);
         }
 
-    sort(xyangles.begin(), xyangles.end(), _complexity_lt);
+    stable_sort(xyangles.begin(), xyangles.end(), _complexity_lt);
     for (auto xyangle : xyangles)
     {
         const int xangle = xyangle.first;
@@ -501,6 +504,76 @@ static void raycast()
         }
     }
 
+    _find_minimal_cellrays();
+}
+
+// The checksum of the tables in los-rays.h, as computed by
+// util/gen-los-rays.py.
+static uint32_t _ray_table_checksum()
+{
+    uint32_t hash = 2166136261U;
+    auto add = [&hash](const int *data, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i)
+            hash = (hash ^ (uint32_t) data[i]) * 16777619U;
+    };
+    add(&los_fullray_data[0][0], sizeof(los_fullray_data) / sizeof(int));
+    add(&los_ray_coord_data[0][0], sizeof(los_ray_coord_data) / sizeof(int));
+    add(&los_cellray_data[0][0], sizeof(los_cellray_data) / sizeof(int));
+    return hash;
+}
+
+// Fill fullrays, ray_coords and min_cellrays from the tables generated
+// at build time. Returns false if they don't fit this build.
+static bool _load_ray_tables()
+{
+    if (LOS_RAYS_RADIUS != LOS_RADIUS
+        || LOS_RAYS_MAX_ANGLE != LOS_MAX_ANGLE
+        || LOS_RAYS_INTERCEPT_MULT != LOS_INTERCEPT_MULT)
+    {
+        dprf("LOS ray tables were generated for different parameters");
+        return false;
+    }
+    if (_ray_table_checksum() != LOS_RAYS_CHECKSUM)
+    {
+        dprf("LOS ray tables have a bad checksum");
+        return false;
+    }
+
+    for (const auto &coord : los_ray_coord_data)
+        ray_coords.emplace_back(coord[0], coord[1]);
+
+    for (const auto &r : los_fullray_data)
+    {
+        los_ray ray(geom::ray((double)r[0] / r[1], (double)r[2] / r[3],
+                              r[4], r[5]));
+        ray.start = r[6];
+        ray.length = r[7];
+        fullrays.push_back(ray);
+    }
+
+    for (const auto &c : los_cellray_data)
+    {
+        cellray cr(fullrays[c[0]], c[1]);
+        cr.imbalance = c[2];
+        cr.first_diag = c[3] != 0;
+        min_cellrays(cr.target()).push_back(cr);
+    }
+
+    return true;
+}
+
+// Set up the rays, from the generated tables if possible.
+static void raycast()
+{
+    static bool done_raycast = false;
+    if (done_raycast)
+        return;
+    done_raycast = true;
+
+    if (!_load_ray_tables())
+        _cast_rays();
+
     // Now create the appropriate blockrays array
     _create_blockrays();
 }
@@ -613,6 +686,61 @@ struct opacity_trans : public opacity_func
     }
 };
 
+// Memo of recent find_ray() results. Entries are only valid for the
+// epoch they were stored in; _handle_los_change() starts a new epoch
+// whenever terrain, opaque clouds or sight-blocking monsters change.
+// Only the shared opacity functions that depend on nothing else are
+// cached, see _ray_cache_opc().
+#define RAY_CACHE_SIZE 1024
+
+struct ray_cache_entry
+{
+    uint32_t epoch;
+    coord_def source;
+    coord_def target;
+    int8_t opc;
+    bool found;
+    ray_def ray;
+};
+
+static ray_cache_entry ray_cache[RAY_CACHE_SIZE];
+static uint32_t ray_cache_epoch = 1;
+
+static const opacity_func * const ray_cache_opcs[] =
+{
+    &opc_default, &opc_fullyopaque, &opc_no_trans, &opc_fully_no_trans,
+    &opc_solid, &opc_solid_see,
+};
+
+// Index of opc in ray_cache_opcs, or -1 if its rays can't be cached.
+static int _ray_cache_opc(const opacity_func& opc)
+{
+    for (unsigned int i = 0; i < ARRAYSZ(ray_cache_opcs); ++i)
+        if (&opc == ray_cache_opcs[i])
+            return i;
+    return -1;
+}
+
+static ray_cache_entry& _ray_cache_slot(const coord_def& source,
+                                        const coord_def& target, int opc)
+{
+    const unsigned int h = (source.x * GYM + source.y) * 2654435761U
+                           ^ (target.x * GYM + target.y) * 40503U
+                           ^ opc;
+    return ray_cache[h % RAY_CACHE_SIZE];
+}
+
+static void _invalidate_ray_cache()
+{
+    if (++ray_cache_epoch == 0)
+    {
+        // Wrapped around; make sure no old entry matches by accident.
+        for (ray_cache_entry &entry : ray_cache)
+            entry.epoch = 0;
+        ray_cache_epoch = 1;
+    }
+}
+
 // Find a nonblocked ray from source to target. Return false if no
 // such ray could be found, otherwise return true and fill ray
 // appropriately.
@@ -632,6 +760,29 @@ bool find_ray(const coord_def& source, const coord_def& target,
     const int absx  = signx * (target.x - source.x);
     const int absy  = signy * (target.y - source.y);
     const coord_def abs = coord_def(absx, absy);
+    if (abs.rdist() > range)
+        return false;
+
+    // Cycling depends on the ray passed in, so isn't cached.
+    const int cache_opc = cycle ? -1 : _ray_cache_opc(opc);
+    ray_cache_entry *entry = nullptr;
+    if (cache_opc >= 0)
+    {
+        entry = &_ray_cache_slot(source, target, cache_opc);
+        if (entry->epoch == ray_cache_epoch && entry->opc == cache_opc
+            && entry->source == source && entry->target == target)
+        {
+            if (entry->found)
+                ray = entry->ray;
+            return entry->found;
+        }
+        entry->epoch  = ray_cache_epoch;
+        entry->source = source;
+        entry->target = target;
+        entry->opc    = cache_opc;
+        entry->found  = false;
+    }
+
     opacity_trans opc_trans = opacity_trans(opc, source, signx, signy);
 
     if (!_find_ray_se(abs, ray, opc_trans, range, cycle))
@@ -647,6 +798,12 @@ bool find_ray(const coord_def& source, const coord_def& target,
     ray.r.start.x += source.x;
     ray.r.start.y += source.y;
 
+    if (entry)
+    {
+        entry->found = true;
+        entry->ray   = ray;
+    }
+
     return true;
 }
 
@@ -835,6 +992,57 @@ static void _losight_quadrant(los_grid& sh, const los_param& dat, int sx, int sy
     }
 }
 
+// The bitboard engine. Instead of uniting the blocked rays of every
+// opaque cell, collect the opaque and half-opaque cells of the quadrant
+// into one mask each, and test each cellray against them with a couple
+// of word operations. A cell is visible as soon as one of the cellrays
+// ending there survives, so most rays are never looked at.
+static void _losight_quadrant_cells(los_grid& sh, const los_param& dat,
+                                    int sx, int sy)
+{
+    quadrant_mask inside, opaque, half;
+
+    for (quadrant_iterator qi; qi; ++qi)
+    {
+        coord_def p = coord_def(sx*(qi->x), sy*(qi->y));
+        if (!dat.los_bounds(p))
+            continue;
+
+        inside.set(*qi);
+        switch (dat.opacity(p))
+        {
+        case OPC_OPAQUE:
+            opaque.set(*qi);
+            break;
+        case OPC_HALF:
+            half.set(*qi);
+            break;
+        default:
+            break;
+        }
+    }
+
+    for (quadrant_iterator qi; qi; ++qi)
+    {
+        coord_def p = coord_def(sx*(qi->x), sy*(qi->y));
+        // Cells on the axes are shared with the previous quadrant.
+        if (!inside(*qi) || sh(p))
+            continue;
+
+        const pair<int, int> &range = cellray_range(*qi);
+        for (int i = range.first; i < range.second; ++i)
+        {
+            // A ray is blocked by one opaque cell, or by two cells of smoke.
+            const quadrant_mask &cells = cellray_cells[i];
+            if ((cells & opaque).any() || (cells & half).count() > 1)
+                continue;
+
+            sh(p) = true;
+            break;
+        }
+    }
+}
+
 struct los_param_funcs : public los_param
 {
     coord_def center;
@@ -871,7 +1079,12 @@ void losight(los_grid& sh, const coord_def& center,
     const int quadrant_x[4] = {  1, -1, -1,  1 };
     const int quadrant_y[4] = {  1,  1, -1, -1 };
     for (int q = 0; q < 4; ++q)
-        _losight_quadrant(sh, dat, quadrant_x[q], quadrant_y[q]);
+    {
+        if (los_engine == LOS_ENGINE_CELLS)
+            _losight_quadrant_cells(sh, dat, quadrant_x[q], quadrant_y[q]);
+        else
+            _losight_quadrant(sh, dat, quadrant_x[q], quadrant_y[q]);
+    }
 
     // Center is always visible.
     const coord_def o = coord_def(0,0);
@@ -897,7 +1110,9 @@ opacity_type mons_opacity(const monster* mon, los_type how)
 // has changed somewhere.
 static void _handle_los_change()
 {
+    _invalidate_ray_cache();
     invalidate_agrid();
+    invalidate_pathfind_fields();
 }
 
 static bool _mons_block_sight(const monster* mons)
@@ -41,6 +41,17 @@ bool cell_see_cell_nocache(const coord_def& p1, const coord_def& p2);
 
 typedef SquareArray<bool, LOS_MAX_RANGE> los_grid;
 
+// Which implementation losight() uses. Both give identical results;
+// LOS_ENGINE_RAYS is the original one, kept for cross-checking.
+enum los_engine_type
+{
+    LOS_ENGINE_RAYS,  // unite per-cell bit vectors of blocked rays
+    LOS_ENGINE_CELLS, // test per-ray bitboards against the opacity masks
+};
+
+void set_los_engine(los_engine_type engine);
+los_engine_type get_los_engine();
+
 void clear_rays_on_exit();
 void losight(los_grid& sh, const coord_def& center,
              const opacity_func &opc = opc_default,
@@ -3,7 +3,6 @@
 #include "losglobal.h"
 
 #include "coord.h"
-#include "coordit.h"
 #include "libutil.h"
 #include "los-def.h"
 
@@ -17,6 +16,23 @@ typedef halflos_t globallos_t[GXM][GYM];
 
 static globallos_t globallos;
 
+// The half-LOS block of a cell is only valid if its stamp equals the
+// current generation. Invalidating just bumps the generation or resets
+// the stamps, and stale blocks are cleared when they are next used.
+typedef uint32_t losgen_t;
+static losgen_t los_generation = 1;
+static losgen_t globallos_stamp[GXM][GYM];
+
+static halflos_t& _halflos_at(const coord_def& c)
+{
+    if (globallos_stamp[c.x][c.y] != los_generation)
+    {
+        memset(globallos[c.x][c.y], 0, sizeof(halflos_t));
+        globallos_stamp[c.x][c.y] = los_generation;
+    }
+    return globallos[c.x][c.y];
+}
+
 static losfield_t* _lookup_globallos(const coord_def& p, const coord_def& q)
 {
     COMPILE_CHECK(LOS_KNOWN * 2 <= sizeof(losfield_t) * 8);
@@ -28,9 +44,9 @@ static losfield_t* _lookup_globallos(const coord_def& p, const coord_def& q)
         return nullptr;
     // p < q iff p.x < q.x || p.x == q.x && p.y < q.y
     if (diff < coord_def(0, 0))
-        return &globallos[q.x][q.y][-diff.x + o_half_x][-diff.y + o_half_y];
+        return &_halflos_at(q)[-diff.x + o_half_x][-diff.y + o_half_y];
     else
-        return &globallos[p.x][p.y][ diff.x + o_half_x][ diff.y + o_half_y];
+        return &_halflos_at(p)[ diff.x + o_half_x][ diff.y + o_half_y];
 }
 
 static void _save_los(los_def* los, los_type l)
@@ -65,15 +81,19 @@ void invalidate_los_around(const coord_def& p)
     int y1 = max(p.y - LOS_MAX_RANGE, 0);
     int x2 = min(p.x, GXM - 1);
     int y2 = min(p.y + LOS_MAX_RANGE, GYM - 1);
-    for (int y = y1; y <= y2; y++)
-        for (int x = x1; x <= x2; x++)
-            memset(globallos[x][y], 0, sizeof(halflos_t));
+    // No generation is 0, so this marks the blocks as stale.
+    for (int x = x1; x <= x2; x++)
+        memset(&globallos_stamp[x][y1], 0, (y2 - y1 + 1) * sizeof(losgen_t));
 }
 
 void invalidate_los()
 {
-    for (rectangle_iterator ri(0); ri; ++ri)
-        memset(globallos[ri->x][ri->y], 0, sizeof(halflos_t));
+    if (++los_generation == 0)
+    {
+        // Wrapped around; make sure no old stamp matches by accident.
+        memset(globallos_stamp, 0, sizeof(globallos_stamp));
+        los_generation = 1;
+    }
 }
 
 static void _update_globallos_at(const coord_def& p, los_type l)
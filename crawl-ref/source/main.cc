@@ -1117,6 +1117,25 @@ static void _input()
         crawl_state.waiting_for_command = true;
         c_input_reset(true);
 
+        // Get explore's next target out of the way while the player looks
+        // at the screen, so it needn't be worked out if they press o.
+        if (Options.explore_precompute)
+        {
+            if (!you.turn_is_over && !has_pending_input() && !kbhit())
+            {
+                update_screen();
+#ifdef USE_TILE
+                tiles.redraw();
+#endif
+#ifdef USE_TILE_WEB
+                tiles.flush_messages();
+#endif
+                precompute_explore_target();
+            }
+            else
+                forget_explore_target();
+        }
+
 #ifdef USE_TILE_LOCAL
         cursor_control con(false);
 #endif
@@ -898,6 +898,9 @@ Menu::~Menu()
 void Menu::clear()
 {
     deleteAll(items);
+#ifdef USE_TILE_WEB
+    _webtiles_item_cache.clear();
+#endif
     m_ui.menu->_queue_allocation();
     last_selected = -1;
 }
@@ -979,6 +982,10 @@ vector<MenuEntry *> Menu::show(bool reuse_selections)
     if (is_set(MF_START_AT_END))
         m_ui.scroller->set_scroll(INT_MAX);
 
+#ifdef USE_TILE_WEB
+    _webtiles_item_cache.clear();
+#endif
+
     do_menu();
 
 #ifdef USE_TILE_WEB
@@ -1888,8 +1895,7 @@ void Menu::update_menu(bool update_entries)
         tiles.json_write_int("total_items", items.size());
         tiles.json_close_object();
         tiles.finish_message();
-        if (items.size() > 0)
-            webtiles_update_items(0, items.size() - 1);
+        webtiles_update_all_items();
     }
 #endif
 }
@@ -2053,6 +2059,10 @@ bool Menu::line_up()
 }
 
 #ifdef USE_TILE_WEB
+// Menus with more items than this only have this many, around the visible
+// ones, sent at first; the client asks for the rest as it scrolls.
+static const int WEBTILES_MENU_WINDOW = 300;
+
 void Menu::webtiles_write_menu(bool replace) const
 {
     if (crawl_state.doing_prev_cmd_again)
@@ -2071,11 +2081,10 @@ void Menu::webtiles_write_menu(bool replace) const
     tiles.json_write_string("more",
             m_keyhelp_more ? "" : more.to_colour_string());
 
-    int count = items.size();
-    int start = 0;
-    int end = start + count;
+    int start, end;
+    webtiles_window(start, end);
 
-    tiles.json_write_int("total_items", count);
+    tiles.json_write_int("total_items", items.size());
     tiles.json_write_int("chunk_start", start);
 
     int first_entry = get_first_visible();
@@ -2084,14 +2093,52 @@ void Menu::webtiles_write_menu(bool replace) const
 
     tiles.json_open_array("items");
 
-    for (int i = start; i < end; ++i)
-        webtiles_write_item(i, items[i]);
+    for (int i = start; i <= end; ++i)
+        webtiles_write_item_cached(i);
 
     tiles.json_close_array();
 
     tiles.json_close_object();
 }
 
+/**
+ * Find the (inclusive) range of items to send when a menu is opened or all
+ * of its items have changed.
+ */
+void Menu::webtiles_window(int &start, int &end) const
+{
+    const int count = items.size();
+    if (count <= WEBTILES_MENU_WINDOW)
+    {
+        start = 0;
+        end = count - 1;
+        return;
+    }
+
+    const int first = is_set(MF_START_AT_END) ? count - 1
+                                              : get_first_visible();
+    start = min(max(0, first - WEBTILES_MENU_WINDOW / 3),
+                count - WEBTILES_MENU_WINDOW);
+    end = start + WEBTILES_MENU_WINDOW - 1;
+}
+
+void Menu::webtiles_write_item_cached(int index) const
+{
+    if (_webtiles_item_cache.size() < items.size())
+        _webtiles_item_cache.resize(items.size());
+
+    string &cached = _webtiles_item_cache[index];
+    if (cached.empty())
+    {
+        tiles.json_write_comma();
+        const size_t mark = tiles.json_mark();
+        webtiles_write_item(index, items[index]);
+        cached = tiles.json_since(mark);
+    }
+    else
+        tiles.json_write_raw(cached);
+}
+
 void Menu::webtiles_scroll(int first)
 {
     // catch and ignore stale scroll events
@@ -2110,6 +2157,8 @@ void Menu::webtiles_scroll(int first)
 
 void Menu::webtiles_handle_item_request(int start, int end)
 {
+    if (items.empty())
+        return;
     start = min(max(0, start), (int)items.size()-1);
     if (end < start) end = start;
     if (end >= (int)items.size())
@@ -2123,7 +2172,7 @@ void Menu::webtiles_handle_item_request(int start, int end)
     tiles.json_open_array("items");
 
     for (int i = start; i <= end; ++i)
-        webtiles_write_item(i, items[i]);
+        webtiles_write_item_cached(i);
 
     tiles.json_close_array();
 
@@ -2145,6 +2194,9 @@ void Menu::webtiles_update_items(int start, int end) const
     ASSERT_RANGE(start, 0, (int) items.size());
     ASSERT_RANGE(end, start, (int) items.size());
 
+    for (int i = start; i <= end && i < (int) _webtiles_item_cache.size(); ++i)
+        _webtiles_item_cache[i].clear();
+
     tiles.json_open_object();
 
     tiles.json_write_string("msg", "update_menu_items");
@@ -2172,6 +2224,40 @@ void Menu::webtiles_update_items(int start, int end) const
 }
 
 
+/**
+ * Send all items again, after a change that may have affected any of them.
+ * Large menus only send the items around the visible ones, and have the
+ * client forget the rest until it asks for them again.
+ */
+void Menu::webtiles_update_all_items() const
+{
+    _webtiles_item_cache.clear();
+    if (items.empty())
+        return;
+
+    if ((int) items.size() <= WEBTILES_MENU_WINDOW)
+    {
+        webtiles_update_items(0, items.size() - 1);
+        return;
+    }
+
+    int start, end;
+    webtiles_window(start, end);
+
+    tiles.json_open_object();
+    tiles.json_write_string("msg", "update_menu_items");
+    tiles.json_write_int("chunk_start", start);
+    tiles.json_write_bool("reset", true);
+
+    tiles.json_open_array("items");
+    for (int i = start; i <= end; ++i)
+        webtiles_write_item_cached(i);
+    tiles.json_close_array();
+
+    tiles.json_close_object();
+    tiles.finish_message();
+}
+
 void Menu::webtiles_update_item(int index) const
 {
     webtiles_update_items(index, index);
@@ -2441,7 +2527,7 @@ int ToggleableMenu::pre_process(int key)
         update_menu();
 
 #ifdef USE_TILE_WEB
-        webtiles_update_items(0, items.size() - 1);
+        webtiles_update_all_items();
 #endif
 
         if (flags & MF_TOGGLE_ACTION)
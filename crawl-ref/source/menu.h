@@ -412,15 +412,21 @@ protected:
 
     void webtiles_write_tiles(const MenuEntry& me) const;
     void webtiles_update_items(int start, int end) const;
+    void webtiles_update_all_items() const;
     void webtiles_update_item(int index) const;
     void webtiles_update_title() const;
     void webtiles_update_scroll_pos() const;
 
     virtual void webtiles_write_title() const;
     virtual void webtiles_write_item(int index, const MenuEntry *me) const;
+    void webtiles_write_item_cached(int index) const;
+    void webtiles_window(int &start, int &end) const;
 
     bool _webtiles_title_changed;
     formatted_string _webtiles_title;
+    // Items as written by webtiles_write_item(), until they are updated or
+    // the menu is shown again. Empty strings are not cached yet.
+    mutable vector<string> _webtiles_item_cache;
 #endif
 
     virtual formatted_string calc_title();
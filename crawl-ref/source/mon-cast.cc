@@ -2276,7 +2276,7 @@ static int _tension_door_closed(set<coord_def> door,
 {
     // this unwind is a bit heavy, but because out-of-los clouds dissipate
     // instantly, they can be wiped out by these door tests.
-    unwind_var<map<coord_def, cloud_struct>> cloud_state(env.cloud);
+    unwind_var<cloud_store> cloud_state(env.cloud);
     _set_door(door, DNGN_CLOSED_DOOR);
     const int new_tension = get_tension(GOD_NO_GOD);
     _set_door(door, old_feat);
@@ -3367,7 +3367,8 @@ bool mons_should_cloud_cone(monster* agent, int power, const coord_def pos)
     return mons_should_fire(tracer);
 }
 
-static bool _spray_tracer(monster *caster, int pow, bolt parent_beam, spell_type spell)
+static bool _spray_tracer(monster *caster, int pow, const bolt &parent_beam,
+                          spell_type spell)
 {
     vector<bolt> beams = get_spray_rays(caster, parent_beam.target,
                                         spell_range(spell, pow), 3);
@@ -18,17 +18,158 @@
 // The pathfinding is an implementation of the A* algorithm. Beginning at the
 // monster position we check all neighbours of a given grid, estimate the
 // distance needed for any shortest path including this grid and push the
-// result into a hash. We can then easily access all points with the shortest
-// distance estimates and then check _their_ neighbours and so on.
+// result into a heap. We can then easily access the point with the shortest
+// distance estimate and then check _its_ neighbours and so on. Among points
+// with the same estimate, the one pushed last is taken first, as it's most
+// likely to be close to the target.
 // The algorithm terminates once we reach the destination since - because
-// of the sorting of grids by shortest distance in the hash - there can be no
+// of the sorting of grids by shortest distance in the heap - there can be no
 // path between start and target that is shorter than the current one. There
 // could be other paths that have the same length but that has no real impact.
-// If the hash has been cleared and the start grid has not been encountered,
+// If the heap has been emptied and the start grid has not been encountered,
 // then there's no path that matches the requirements fed into monster_pathfind.
 // (These requirements are usually preference of habitat of a specific monster
 // or a limit of the distance between start and any grid on the path.)
 
+struct pathfind_node
+{
+    int total;
+    // Order of pushing; also tells whether this node is still current.
+    unsigned int seq;
+    coord_def pos;
+
+    // Heap order: shorter total first, then the most recently pushed.
+    bool operator<(const pathfind_node &other) const
+    {
+        return total > other.total
+               || total == other.total && seq < other.seq;
+    }
+};
+
+// Only cells with a current stamp have a valid distance, so nothing needs
+// clearing between searches.
+struct pathfind_workspace
+{
+    int dist[GXM][GYM];
+    int prev[GXM][GYM];
+    unsigned int open_seq[GXM][GYM];
+    unsigned int stamp[GXM][GYM];
+    unsigned int generation = 0;
+    unsigned int next_seq = 0;
+    vector<pathfind_node> open;
+
+    void clear()
+    {
+        if (++generation == 0)
+        {
+            // Wrapped around; make sure no old stamp matches by accident.
+            memset(stamp, 0, sizeof(stamp));
+            generation = 1;
+        }
+        next_seq = 0;
+        open.clear();
+    }
+};
+
+// Workspaces not in use by any monster_pathfind. There is more than one
+// only if searches are nested.
+static vector<unique_ptr<pathfind_workspace>> _free_workspaces;
+
+static pathfind_workspace *_get_workspace()
+{
+    if (_free_workspaces.empty())
+        return new pathfind_workspace;
+
+    pathfind_workspace *ws = _free_workspaces.back().release();
+    _free_workspaces.pop_back();
+    return ws;
+}
+
+// Many monsters chasing the same target (usually the player) all search
+// towards it. For those, the distances from the target to every cell that
+// could be on any monster's path are worked out once, and used as the
+// estimated cost. This is never more than the real cost of a path for any
+// monster, so the paths found are still shortest ones, but far fewer
+// positions need to be looked at.
+struct pathfind_field
+{
+    coord_def target;
+    // you.elapsed_time when this was last asked for; -1 if unused.
+    int time = -1;
+    bool built = false;
+    FixedArray<int, GXM, GYM> dist;
+};
+
+#define NUM_PATHFIND_FIELDS 4
+static pathfind_field _pathfind_fields[NUM_PATHFIND_FIELDS];
+
+// Anything that monster_pathfind::traversable() might let through.
+static bool _field_passable(const coord_def &p)
+{
+    const dungeon_feature_type feat = grd(p);
+    return feat_is_closed_door(feat)
+           || !feat_is_wall(feat) && !feat_is_opaque(feat);
+}
+
+static void _build_pathfind_field(pathfind_field &field)
+{
+    field.dist.init(INFINITE_DISTANCE);
+    field.dist(field.target) = 0;
+
+    vector<coord_def> perimeter(1, field.target);
+    vector<coord_def> next_perimeter;
+    for (int d = 1; !perimeter.empty(); ++d)
+    {
+        for (const coord_def &p : perimeter)
+        {
+            for (int i = 0; i < 8; ++i)
+            {
+                const coord_def np = p + Compass[i];
+                if (in_bounds(np) && field.dist(np) == INFINITE_DISTANCE
+                    && _field_passable(np))
+                {
+                    field.dist(np) = d;
+                    next_perimeter.push_back(np);
+                }
+            }
+        }
+        perimeter.swap(next_perimeter);
+        next_perimeter.clear();
+    }
+    field.built = true;
+}
+
+// The shared distances to target, if it's been searched for before this
+// turn; the first search for a target goes without, as it may be the only
+// one.
+static const pathfind_field *_get_pathfind_field(const coord_def &target)
+{
+    pathfind_field *oldest = &_pathfind_fields[0];
+    for (pathfind_field &field : _pathfind_fields)
+    {
+        if (field.time == you.elapsed_time && field.target == target)
+        {
+            if (!field.built)
+                _build_pathfind_field(field);
+            return &field;
+        }
+        if (field.time < oldest->time)
+            oldest = &field;
+    }
+
+    oldest->target = target;
+    oldest->time = you.elapsed_time;
+    oldest->built = false;
+    return nullptr;
+}
+
+// The terrain changed, so the shared distances may be wrong.
+void invalidate_pathfind_fields()
+{
+    for (pathfind_field &field : _pathfind_fields)
+        field.time = -1;
+}
+
 int mons_tracking_range(const monster* mon)
 {
     int range = 0;
@@ -68,12 +209,25 @@ int mons_tracking_range(const monster* mon)
 monster_pathfind::monster_pathfind()
     : mons(nullptr), start(), target(), pos(), allow_diagonals(true),
       traverse_unmapped(false), range(0), min_length(0), max_length(0),
-      dist(), prev(), hash()
+      ws(_get_workspace()), field(nullptr)
 {
 }
 
 monster_pathfind::~monster_pathfind()
 {
+    _free_workspaces.emplace_back(ws);
+}
+
+int monster_pathfind::get_dist(const coord_def &p) const
+{
+    return ws->stamp[p.x][p.y] == ws->generation ? ws->dist[p.x][p.y]
+                                                 : INFINITE_DISTANCE;
+}
+
+void monster_pathfind::set_dist(const coord_def &p, int d)
+{
+    ws->dist[p.x][p.y] = d;
+    ws->stamp[p.x][p.y] = ws->generation;
 }
 
 void monster_pathfind::set_range(int r)
@@ -84,7 +238,7 @@ void monster_pathfind::set_range(int r)
 
 coord_def monster_pathfind::next_pos(const coord_def &c) const
 {
-    return c + Compass[prev[c.x][c.y]];
+    return c + Compass[ws->prev[c.x][c.y]];
 }
 
 // The main method in the monster_pathfind class.
@@ -139,18 +293,16 @@ bool monster_pathfind::start_pathfind(bool msg)
     //       surrounded by shallow water or floor, or if a foe is hiding in
     //       a wall.
 
+    field = in_bounds(target) ? _get_pathfind_field(target) : nullptr;
     max_length = min_length = grid_distance(pos, target);
-    for (int i = 0; i < GXM; i++)
-        for (int j = 0; j < GYM; j++)
-            dist[i][j] = INFINITE_DISTANCE;
-
-    dist[pos.x][pos.y] = 0;
+    ws->clear();
+    set_dist(pos, 0);
 
     bool success = false;
     do
     {
         // Calculate the distance to all neighbours of the current position,
-        // and add them to the hash, if they haven't already been looked at.
+        // and add them to the heap, if they haven't already been looked at.
         success = calc_path_to_neighbours();
         if (success)
             return true;
@@ -211,11 +363,11 @@ bool monster_pathfind::calc_path_to_neighbours()
 
         // Ignore this grid if it takes us above the allowed distance
         // away from the target.
-        if (range && estimated_cost(npos) > range)
+        if (range && grid_distance(npos, target) > range)
             continue;
 
-        distance = dist[pos.x][pos.y] + travel_cost(npos);
-        old_dist = dist[npos.x][npos.y];
+        distance = get_dist(pos) + travel_cost(npos);
+        old_dist = get_dist(npos);
 
         // Also bail out if this would make the path longer than twice the
         // allowed distance from the target. (This factor may need tuning.)
@@ -234,12 +386,18 @@ bool monster_pathfind::calc_path_to_neighbours()
         // INFINITE), update the position.
         if (distance < old_dist)
         {
+            // Don't bother with positions that the target can't be reached
+            // from at all.
+            const int estimate = estimated_cost(npos);
+            if (estimate == INFINITE_DISTANCE)
+                continue;
+
             // Calculate new total path length.
-            total = distance + estimated_cost(npos);
+            total = distance + estimate;
             if (old_dist == INFINITE_DISTANCE)
             {
 #ifdef DEBUG_PATHFIND
-                mprf("Adding (%d,%d) to hash (total dist = %d)",
+                mprf("Adding (%d,%d) to heap (total dist = %d)",
                      npos.x, npos.y, total);
 #endif
                 add_new_pos(npos, total);
@@ -257,7 +415,7 @@ bool monster_pathfind::calc_path_to_neighbours()
             }
 
             // Update distance start->pos.
-            dist[npos.x][npos.y] = distance;
+            set_dist(npos, distance);
 
             // Set backtracking information.
             // Converts the Compass direction to its counterpart.
@@ -265,7 +423,7 @@ bool monster_pathfind::calc_path_to_neighbours()
             //      7  .  3   ==>   3  .  7       e.g. (3 + 4) % 8          = 7
             //      6  5  4         2  1  0            (7 + 4) % 8 = 11 % 8 = 3
 
-            prev[npos.x][npos.y] = (dir + 4) % 8;
+            ws->prev[npos.x][npos.y] = (dir + 4) % 8;
 
             // Are we finished?
             if (npos == target)
@@ -280,34 +438,31 @@ bool monster_pathfind::calc_path_to_neighbours()
     return false;
 }
 
-// Starting at known min_length (minimum total estimated path distance), check
-// the hash for existing vectors, then pick the last entry of the first vector
-// that matches. Update min_length, if necessary.
+// Pop the position with the shortest total estimated path distance off the
+// heap, skipping entries that have since been superseded. Update min_length.
 bool monster_pathfind::get_best_position()
 {
-    for (int i = min_length; i <= max_length; i++)
+    vector<pathfind_node> &open = ws->open;
+    while (!open.empty())
     {
-        if (!hash[i].empty())
-        {
-            if (i > min_length)
-                min_length = i;
+        pop_heap(open.begin(), open.end());
+        const pathfind_node node = open.back();
+        open.pop_back();
 
-            vector<coord_def> &vec = hash[i];
-            // Pick the last position pushed into the vector as it's most
-            // likely to be close to the target.
-            pos = vec[vec.size()-1];
-            vec.pop_back();
+        unsigned int &seq = ws->open_seq[node.pos.x][node.pos.y];
+        if (seq != node.seq)
+            continue;
+        seq = 0;
 
-#ifdef DEBUG_PATHFIND
-            mprf("Returning (%d, %d) as best pos with total dist %d.",
-                 pos.x, pos.y, min_length);
-#endif
+        pos = node.pos;
+        min_length = node.total;
 
-            return true;
-        }
 #ifdef DEBUG_PATHFIND
-        mprf("No positions for path length %d.", i);
+        mprf("Returning (%d, %d) as best pos with total dist %d.",
+             pos.x, pos.y, min_length);
 #endif
+
+        return true;
     }
 
     // Nothing found? Then there's no path! :(
@@ -331,7 +486,7 @@ vector<coord_def> monster_pathfind::backtrack()
     int dir;
     do
     {
-        dir = prev[pos.x][pos.y];
+        dir = ws->prev[pos.x][pos.y];
         pos = pos + Compass[dir];
         ASSERT_IN_BOUNDS(pos);
 #ifdef DEBUG_PATHFIND
@@ -486,32 +641,28 @@ int monster_pathfind::mons_travel_cost(coord_def npos)
     return 1;
 }
 
-// The estimated cost to reach a grid is simply max(dx, dy).
+// The estimated cost to reach a grid is the shared distance to the target,
+// if there is one, and otherwise simply max(dx, dy).
 int monster_pathfind::estimated_cost(coord_def p)
 {
+    if (field)
+        return field->dist(p);
+
     return grid_distance(p, target);
 }
 
 void monster_pathfind::add_new_pos(coord_def npos, int total)
 {
-    hash[total].push_back(npos);
+    // Sequence numbers start at 1, as 0 marks a position that isn't open.
+    const unsigned int seq = ++ws->next_seq;
+    ws->open_seq[npos.x][npos.y] = seq;
+    ws->open.push_back({total, seq, npos});
+    push_heap(ws->open.begin(), ws->open.end());
 }
 
 void monster_pathfind::update_pos(coord_def npos, int total)
 {
-    // Find hash position of old distance and delete it,
-    // then call_add_new_pos.
-    int old_total = dist[npos.x][npos.y] + estimated_cost(npos);
-
-    vector<coord_def> &vec = hash[old_total];
-    for (unsigned int i = 0; i < vec.size(); i++)
-    {
-        if (vec[i] == npos)
-        {
-            vec.erase(vec.begin() + i);
-            break;
-        }
-    }
-
+    // The old heap entry is left behind; add_new_pos() gives the position
+    // a new sequence number, so get_best_position() will skip it.
     add_new_pos(npos, total);
 }
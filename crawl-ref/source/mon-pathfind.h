@@ -1,8 +1,11 @@
 #pragma once
 
 class monster;
+struct pathfind_workspace;
+struct pathfind_field;
 
 int mons_tracking_range(const monster* mon);
+void invalidate_pathfind_fields();
 
 class monster_pathfind
 {
@@ -10,6 +13,9 @@ public:
     monster_pathfind();
     virtual ~monster_pathfind();
 
+    monster_pathfind(const monster_pathfind &other) = delete;
+    monster_pathfind &operator=(const monster_pathfind &other) = delete;
+
     // public methods
     void set_range(int r);
     coord_def next_pos(const coord_def &p) const;
@@ -34,6 +40,9 @@ protected:
     void update_pos(coord_def pos, int total);
     bool get_best_position();
 
+    int get_dist(const coord_def &p) const;
+    void set_dist(const coord_def &p, int d);
+
     // The monster trying to find a path.
     const monster* mons;
 
@@ -59,10 +68,12 @@ protected:
     int min_length;
     int max_length;
 
-    // The array of distances from start to any already tried point.
-    int dist[GXM][GYM];
-    // An array to store where we came from on a given shortest path.
-    int prev[GXM][GYM];
+    // The distances from start to any already tried point, where we came
+    // from on a given shortest path, and the open positions. These are
+    // large, so they are borrowed from a pool rather than set up anew for
+    // each search.
+    pathfind_workspace *ws;
 
-    FixedVector<vector<coord_def>, GXM * GYM> hash;
+    // Distances to the target shared with other searches for it, if any.
+    const pathfind_field *field;
 };
@@ -136,6 +136,11 @@ private:
 
 private:
     FixedArray<noise_cell, GXM, GYM> cells;
+    // Cells that have had noise applied since the last reset().
+    vector<coord_def> touched_cells;
+    // The current and next layer of the propagation, kept between
+    // calls to reuse their storage.
+    vector<coord_def> noise_perimeter[2];
     vector<noise_t> noises;
     int affected_actor_count;
 };
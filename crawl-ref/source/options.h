@@ -386,6 +386,9 @@ public:
     // Wait for rest wait percent HP and MP before exploring.
     bool        explore_auto_rest;
 
+    // Work out where explore goes next while waiting for a command.
+    bool        explore_precompute;
+
     bool        travel_key_stop;   // Travel stops on keypress.
 
     vector<sound_mapping> sound_mappings;
@@ -580,6 +583,7 @@ public:
     bool        tile_level_map_hide_messages;
     bool        tile_level_map_hide_sidebar;
     bool        tile_web_mouse_control;
+    bool        tile_web_compact_map;
 #endif
 #endif // USE_TILE
 
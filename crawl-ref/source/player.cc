@@ -2375,6 +2375,7 @@ void forget_map(bool rot)
     const int radius = (rot_resist ? 200 : 100);
 
     const int scalar = 0xFF;
+    vector<coord_def> excludes;
     for (rectangle_iterator ri(0); ri; ++ri)
     {
         const coord_def &p = *ri;
@@ -2400,8 +2401,12 @@ void forget_map(bool rot)
 #ifdef USE_TILE
         tile_forget_map(p);
 #endif
+        excludes.push_back(p);
     }
 
+    // Exclusions look through what was forgotten.
+    update_exclusion_los(excludes);
+
     ash_detect_portals(is_map_persistent());
 #ifdef USE_TILE
     tiles.update_minimap_bounds();
@@ -35,10 +35,13 @@
 #include "state.h"
 #include "stringutil.h"
 #include "terrain.h"
+#include "unwind.h"
 #include "view.h"
 #include "viewchar.h"
 
-static noise_grid _noise_grid;
+// Noises are registered in one grid while the other is propagated.
+static noise_grid _noise_grids[2];
+static noise_grid *_noise_grid = &_noise_grids[0];
 static void _actor_apply_noise(actor *act,
                                const coord_def &apparent_source,
                                int noise_intensity_millis,
@@ -764,17 +767,32 @@ void yell(const actor* mon)
 
 void apply_noises()
 {
-    // [ds] This copying isn't awesome, but we cannot otherwise handle
-    // the case where one set of noises wakes up monsters who then let
-    // out yips of their own, modifying _noise_grid while it is in the
-    // middle of propagate_noise().
-    if (_noise_grid.dirty())
+    // One set of noises may wake up monsters who then let out yips of
+    // their own, which mustn't modify the grid while it is in the middle
+    // of propagate_noise(). New noises go to the other grid instead, and
+    // are applied next time.
+    if (!_noise_grid->dirty())
+        return;
+
+    // Should this ever be called while propagating, fall back to copying
+    // the grid, as the other one is in use.
+    static bool applying = false;
+    if (applying)
     {
-        noise_grid copy = _noise_grid;
+        noise_grid copy = *_noise_grid;
         // Reset the main grid.
-        _noise_grid.reset();
+        _noise_grid->reset();
         copy.propagate_noise();
+        return;
     }
+
+    noise_grid &grid = *_noise_grid;
+    _noise_grid = &_noise_grids[_noise_grid == &_noise_grids[0]];
+    ASSERT(!_noise_grid->dirty());
+
+    unwind_var<bool> now_applying(applying, true);
+    grid.propagate_noise();
+    grid.reset();
 }
 
 // noisy() has a messaging service for giving messages to the player
@@ -815,7 +833,7 @@ bool noisy(int original_loudness, const coord_def& where,
     // Add +1 to scaled_loudness so that all squares adjacent to a
     // sound of loudness 1 will hear the sound.
     const string noise_msg(msg? msg : "");
-    _noise_grid.register_noise(
+    _noise_grid->register_noise(
         noise_t(where, noise_msg, (scaled_loudness + 1) * multiplier, who));
 
     // Some users of noisy() want an immediate answer to whether the
@@ -985,13 +1003,17 @@ int noise_cell::turn_angle(const coord_def &next_delta) const
 }
 
 noise_grid::noise_grid()
-    : cells(), noises(), affected_actor_count(0)
+    : cells(), touched_cells(), noises(), affected_actor_count(0)
 {
 }
 
+// Only the cells that noise reached need clearing, which is usually a
+// small part of the level.
 void noise_grid::reset()
 {
-    cells.init(noise_cell());
+    for (const coord_def &p : touched_cells)
+        cells(p) = noise_cell();
+    touched_cells.clear();
     noises.clear();
     affected_actor_count = 0;
 }
@@ -1004,6 +1026,8 @@ void noise_grid::register_noise(const noise_t &noise)
         const int noise_index = noises.size();
         noises.push_back(noise);
         noises[noise_index].noise_id = noise_index;
+        if (target_cell.noise_id == -1)
+            touched_cells.push_back(noise.noise_source);
         cells(noise.noise_source).apply_noise(noise.noise_intensity_millis,
                                               noise_index,
                                               0,
@@ -1020,8 +1044,9 @@ void noise_grid::propagate_noise()
     dprf(DIAG_NOISE, "noise_grid: %u noises to apply",
          (unsigned int)noises.size());
 #endif
-    vector<coord_def> noise_perimeter[2];
     int circ_index = 0;
+    noise_perimeter[0].clear();
+    noise_perimeter[1].clear();
 
     for (const noise_t &noise : noises)
         noise_perimeter[circ_index].push_back(noise.noise_source);
@@ -1113,13 +1138,18 @@ bool noise_grid::propagate_noise_to_neighbour(int base_attenuation,
     if (noise_is_audible(attenuated_noise_intensity))
     {
         const int neighbour_old_distance = neighbour.noise_travel_distance;
+        const bool untouched = neighbour.noise_id == -1;
         if (neighbour.apply_noise(attenuated_noise_intensity,
                                   cell.noise_id,
                                   travel_distance,
                                   next_pos - current_pos))
+        {
+            if (untouched)
+                touched_cells.push_back(next_pos);
             // Return true only if we hadn't already registered this
             // cell as a neighbour (presumably with a lower volume).
             return neighbour_old_distance != travel_distance;
+        }
     }
     return false;
 }
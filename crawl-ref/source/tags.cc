@@ -4355,9 +4355,8 @@ static void tag_construct_level(writer &th)
 
     // how many clouds?
     marshallShort(th, env.cloud.size());
-    for (const auto& entry : env.cloud)
+    for (const cloud_struct& cloud : env.cloud)
     {
-        const cloud_struct& cloud = entry.second;
         marshallByte(th, cloud.type);
         ASSERT(cloud.type != CLOUD_NONE);
         ASSERT_IN_BOUNDS(cloud.pos);
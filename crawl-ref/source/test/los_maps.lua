@@ -9,18 +9,7 @@ local floor = dgn.find_feature_number("floor")
 local stone_wall = dgn.find_feature_number("stone_wall")
 local water = dgn.find_feature_number("deep_water")
 
-local function test_los_map(map)
-  dgn.reset_level()
-  -- choose random debug map; better choose all
-  dgn.tags(map, "no_rotate no_vmirror no_hmirror no_pool_fixup")
-  local name = dgn.name(map)
-  -- local width, height = dgn.mapsize(map) -- returns (0,0)
-  local function place_map()
-    return dgn.place_map(map, true, true)
-  end
-  dgn.with_map_anchors(30, 30, place_map)
-  you.moveto(30, 30)
-  crawl.redraw_view()
+local function check_los_map(name)
   for x = 0, 9 do
     for y = 0, 9 do
       local xa = 30 + x
@@ -49,6 +38,27 @@ local function test_los_map(map)
   end
 end
 
+local function test_los_map(map)
+  dgn.reset_level()
+  -- choose random debug map; better choose all
+  dgn.tags(map, "no_rotate no_vmirror no_hmirror no_pool_fixup")
+  local name = dgn.name(map)
+  -- local width, height = dgn.mapsize(map) -- returns (0,0)
+  local function place_map()
+    return dgn.place_map(map, true, true)
+  end
+  dgn.with_map_anchors(30, 30, place_map)
+  you.moveto(30, 30)
+  crawl.redraw_view()
+  -- Both LOS engines have to get it right.
+  local old_engine = debug.los_engine()
+  for _, engine in ipairs({ "rays", "cells" }) do
+    debug.los_engine(engine)
+    check_los_map(name)
+  end
+  debug.los_engine(old_engine)
+end
+
 local function test_los_maps()
   local map = dgn.map_by_tag("debug_los")
   assert(map, "Could not find debug-los maps (tag 'debug_los')")
@@ -3,11 +3,43 @@
 local FAILMAP = 'losfail.map'
 local checks = 0
 
+-- Collect the cells visible from the player's position as a string.
+local function visible_cells()
+  local you_x, you_y = you.pos()
+  local seen = { }
+  for y = -8, 8 do
+    for x = -8, 8 do
+      local px, py = x + you_x, y + you_y
+      table.insert(seen, dgn.in_bounds(px, py) and you.see_cell(px, py)
+                         and "1" or "0")
+    end
+  end
+  return table.concat(seen)
+end
+
+-- Check that both LOS engines agree from the player's position.
+local function test_los_engines()
+  local old_engine = debug.los_engine("rays")
+  local rays = visible_cells()
+  debug.los_engine("cells")
+  local cells = visible_cells()
+  debug.los_engine(old_engine)
+
+  if rays ~= cells then
+    local you_x, you_y = you.pos()
+    debug.dump_map(FAILMAP)
+    assert(false,
+           "LOS engines disagree (iter #" .. checks .. ") at " ..
+             dgn.point(you_x, you_y) .. ". Map saved to " .. FAILMAP)
+  end
+end
+
 local function test_losight_symmetry()
   -- Send the player to a random spot on the level.
   you.random_teleport()
 
   checks = checks + 1
+  test_los_engines()
   local you_x, you_y = you.pos()
 
   local visible_spots = { }
@@ -6,7 +6,10 @@
 
 #include <cerrno>
 #include <cstdarg>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/types.h>
 #include <sys/un.h>
@@ -20,6 +23,7 @@
 #include "english.h"
 #include "env.h"
 #include "files.h"
+#include "hash.h"
 #include "item-name.h"
 #include "json.h"
 #include "json-wrapper.h"
@@ -68,9 +72,23 @@ static unsigned int get_milliseconds()
     return ((unsigned int) tv.tv_sec) * 1000 + tv.tv_usec / 1000;
 }
 
+static uint64_t get_microseconds()
+{
+    timeval tv;
+    gettimeofday(&tv, nullptr);
+
+    return ((uint64_t) tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
 TilesFramework tiles;
 
 TilesFramework::TilesFramework() :
+      m_msg_start_usec(0),
+      m_keyframe_state_bytes(0),
+      m_keyframe_bytes(0),
+      m_keyframe_valid(false),
+      m_recording_keyframe(false),
+      m_keyframe_only(false),
       m_controlled_from_web(false),
       _send_lock(false),
       m_last_ui_state(UI_INIT),
@@ -81,7 +99,10 @@ TilesFramework::TilesFramework() :
       m_next_flash_colour(BLACK),
       m_need_full_map(true),
       m_text_menu("menu_txt"),
-      m_print_fg(15)
+      m_print_fg(15),
+      m_compact_cells(false),
+      m_cell_bits(0),
+      m_frame_pending(false)
 {
     screen_cell_t default_cell;
     default_cell.tile.bg = TILE_FLAG_UNSEEN;
@@ -98,6 +119,13 @@ void TilesFramework::shutdown()
     if (m_sock_name.empty())
         return;
 
+    _send_stats();
+
+    // Give slow receivers a few seconds to get the last messages, such as
+    // the exit reason.
+    for (int i = 0; i < 50 && _flush_queues(); ++i)
+        usleep(100 * 1000);
+
     close(m_sock);
     remove(m_sock_name.c_str());
 }
@@ -158,18 +186,94 @@ string TilesFramework::get_message()
 
 void TilesFramework::write_message(const char *format, ...)
 {
-    char buf[2048];
-    int len;
-
     va_list argp;
     va_start(argp, format);
-    if ((len = vsnprintf(buf, sizeof(buf), format, argp)) < 0)
-        die("Webtiles message format error! (%s)", format);
-    else if (len >= (int)sizeof(buf))
-        die("Webtiles message too long! (%d)", len);
+    _write_message_v(format, argp);
     va_end(argp);
+}
+
+/**
+ * Format a message fragment directly into the message buffer, without going
+ * through a temporary buffer or limiting its length.
+ */
+void TilesFramework::_write_message_v(const char *format, va_list argp)
+{
+    // Usually enough; the buffer keeps its capacity between messages, so
+    // this rarely allocates.
+    const size_t guess = 256;
+    const size_t old_size = m_msg_buf.size();
+    if (!old_size)
+        _start_message_timer();
+    m_msg_buf.resize(old_size + guess);
+
+    va_list args;
+    va_copy(args, argp);
+    const int len = vsnprintf(&m_msg_buf[old_size], guess, format, args);
+    va_end(args);
+    if (len < 0)
+        die("Webtiles message format error! (%s)", format);
 
-    m_msg_buf.append(buf);
+    if ((size_t) len >= guess)
+    {
+        m_msg_buf.resize(old_size + len + 1);
+        va_copy(args, argp);
+        vsnprintf(&m_msg_buf[old_size], len + 1, format, args);
+        va_end(args);
+    }
+    m_msg_buf.resize(old_size + len);
+}
+
+// The most data that may be queued for a single receiver. Receivers that fall
+// further behind stop getting updates until their queue drains, and are then
+// sent the whole game state again.
+static const size_t MAX_QUEUED_BYTES = 1024 * 1024;
+
+// Once the messages added to the keyframe are this many times the size of the
+// state itself, it is generated again the next time we wait for input.
+static const size_t KEYFRAME_REFRESH_GROWTH = 1;
+// If there is no chance to do that, it is dropped at this size, and built
+// again when it is next needed.
+static const size_t KEYFRAME_MAX_GROWTH = 4;
+
+/**
+ * Find a message's type, which is taken from its leading "msg" field.
+ * Messages for the server keep their star.
+ */
+static string _message_type(const string &msg)
+{
+    static const char prefix[] = "{\"msg\":\"";
+    const size_t prefix_len = sizeof(prefix) - 1;
+    const size_t star = !msg.empty() && msg[0] == '*';
+
+    string type = star ? "*" : "";
+    size_t end;
+    if (msg.compare(star, prefix_len, prefix) == 0
+        && (end = msg.find('"', star + prefix_len)) != string::npos)
+    {
+        type.append(msg, star + prefix_len, end - star - prefix_len);
+    }
+    else
+        type.append("other");
+
+    return type;
+}
+
+// Messages that set part of the state the clients show, whatever it was
+// before. Replaying these after the full state brings every client to the
+// same state, however many of them it has already seen.
+static bool _is_keyframe_state_message(const string &type)
+{
+    return type == "map" || type == "player" || type == "cursor"
+           || type == "flash" || type == "text_cursor" || type == "ui_state"
+           || type == "input_mode" || type == "layout" || type == "options"
+           || type == "version";
+}
+
+// Messages that don't change what the clients show afterwards. New game
+// messages are only ever sent once, so they stay out of the keyframe too.
+static bool _is_keyframe_ignored_message(const string &type)
+{
+    return type[0] == '*' || type == "msgs" || type == "delay";
 }
 
 void TilesFramework::finish_message()
@@ -188,102 +292,428 @@ void TilesFramework::finish_message()
     }
 
     m_msg_buf.append("\n");
-    const char* fragment_start = m_msg_buf.data();
-    const char* data_end = m_msg_buf.data() + m_msg_buf.size();
-    int fragments = 0;
-    while (fragment_start < data_end)
+
+    const string type = _message_type(m_msg_buf);
+
+    // Keep the keyframe up to date with what the clients have been shown.
+    // Anything other clients would act on again if it were replayed, such as
+    // opening a menu or popup, means it has to be generated afresh instead.
+    if (m_recording_keyframe)
+    {
+        m_keyframe.push_back(m_msg_buf);
+        m_keyframe_bytes += m_msg_buf.size();
+    }
+    else if (m_keyframe_valid && m_sole_receiver.empty()
+             && !_is_keyframe_ignored_message(type))
     {
-        int fragment_size = data_end - fragment_start;
-        if (fragment_size > m_max_msg_size)
-            fragment_size = m_max_msg_size;
-        fragments++;
+        if (_is_keyframe_state_message(type))
+        {
+            m_keyframe.push_back(m_msg_buf);
+            m_keyframe_bytes += m_msg_buf.size();
+        }
 
-        for (unsigned int i = 0; i < m_dest_addrs.size(); ++i)
+        // Also drop it if it has gone too long without being refreshed.
+        if (!_is_keyframe_state_message(type)
+            || m_keyframe_bytes - m_keyframe_state_bytes
+               > KEYFRAME_MAX_GROWTH * m_keyframe_state_bytes)
         {
-            int retries = 30;
-            ssize_t sent = 0;
-            while (sent < fragment_size)
-            {
-                ssize_t retval = sendto(m_sock, fragment_start + sent,
-                    fragment_size - sent, 0, (sockaddr*) &m_dest_addrs[i],
-                    sizeof(sockaddr_un));
-#ifdef DEBUG_WEBSOCKETS
-                fprintf(stderr,
-                            "    trying to send fragment to client %d...", i);
-#endif
-                if (retval <= 0)
-                {
-                    const char *errmsg = retval == 0 ? "No bytes sent"
-                                                     : strerror(errno);
-                    if (--retries <= 0)
-                        die("Socket write error: %s", errmsg);
+            m_keyframe_valid = false;
+            m_keyframe.clear();
+            m_keyframe_bytes = 0;
+        }
+    }
 
-                    if (retval == 0 || errno == ENOBUFS || errno == EWOULDBLOCK
-                        || errno == EINTR || errno == EAGAIN)
-                    {
-                        // Wait for half a second at first (up to five), then
-                        // try again.
-                        const int sleep_time = retries > 25 ? 2 * 1000
-                                             : retries > 10 ? 500 * 1000
-                                             : 5000 * 1000;
+    if (m_keyframe_only)
+    {
+        m_msg_start_usec = 0;
+        m_msg_buf.clear();
+        return;
+    }
+
+    MessageStats &stats = m_msg_stats[type];
+    if (m_msg_start_usec)
+        stats.serialise_usec += get_microseconds() - m_msg_start_usec;
+    m_msg_start_usec = 0;
+
+    _send_to_receivers(m_msg_buf, stats);
+
+    m_msg_buf.clear();
+    m_need_flush = true;
 #ifdef DEBUG_WEBSOCKETS
-                        fprintf(stderr, "failed (%s), sleeping for %dms.\n",
-                                                    errmsg, sleep_time / 1000);
+    fprintf(stderr, "websocket: Sent %d bytes.\n", initial_buf_size);
 #endif
-                        usleep(sleep_time);
-                    }
-                    else if (errno == ECONNREFUSED || errno == ENOENT)
-                    {
-                        // the other side is dead
+}
+
+void TilesFramework::_send_to_receivers(const string &msg,
+                                        MessageStats &stats)
+{
+    stats.messages++;
+    stats.bytes += msg.size();
+    stats.fragments += (msg.size() + m_max_msg_size - 1) / m_max_msg_size;
+
+    for (unsigned int i = 0; i < m_dests.size(); ++i)
+    {
+        Receiver &dest = m_dests[i];
+        if (!m_sole_receiver.empty()
+            && m_sole_receiver != dest.addr.sun_path)
+        {
+            continue;
+        }
+
+        // This receiver will get everything again once it catches up.
+        if (dest.needs_resync)
+            continue;
+
+        // Messages must arrive in order, so only send directly if nothing
+        // is queued.
+        const string *to_send = &msg;
+        string notice;
+        int sent = 0;
+        if (!_flush_queue(dest))
+            sent = -1;
+        else if (dest.queue.empty())
+        {
+            uint64_t pos;
+            if (dest.ring && (int) msg.size() > m_max_msg_size
+                && dest.ring->write(msg, pos))
+            {
+                notice = dest.ring->notice(pos, msg.size());
+                to_send = &notice;
+            }
+            sent = _send_nonblocking(dest, to_send->data(), to_send->size());
+        }
+
+        if (sent < 0)
+        {
+            // the other side is dead
 #ifdef DEBUG_WEBSOCKETS
-                        fprintf(stderr,
-                            "failed (%s), breaking.\n", errmsg);
+            fprintf(stderr, "websocket: Client %d is gone.\n", i);
 #endif
-                        m_dest_addrs.erase(m_dest_addrs.begin() + i);
-                        i--;
-                        break;
-                    }
-                    else
-                        die("Socket write error: %s", errmsg);
-                }
-                else
-                {
+            m_dests.erase(m_dests.begin() + i);
+            i--;
+            continue;
+        }
+
+        if (sent < (int) to_send->size())
+        {
 #ifdef DEBUG_WEBSOCKETS
-                    fprintf(stderr, "fragment size %d sent.\n", fragment_size);
+            fprintf(stderr, "websocket: Queueing %d bytes for client %d.\n",
+                            (int) to_send->size() - sent, i);
 #endif
-                    sent += retval;
-                }
-            }
+            _queue_message(dest, *to_send, sent);
+            stats.retries++;
         }
+    }
+}
+
+// Layout of the start of a ring buffer file. Positions count bytes since
+// the ring was created, so it is empty when they are equal; the writer only
+// updates write_pos, and the reader only read_pos.
+struct ring_header
+{
+    char magic[4];
+    uint32_t size; // of the data that follows the header
+    uint64_t write_pos;
+    uint64_t read_pos;
+};
+static const char RING_MAGIC[4] = { 'D', 'C', 'R', 'B' };
+static const size_t RING_DATA_OFFSET = 64;
+COMPILE_CHECK(sizeof(ring_header) <= RING_DATA_OFFSET);
+
+// Written in front of each message in the ring, so that the reader can tell
+// if it has lost track of where messages are.
+struct ring_record
+{
+    uint64_t pos;
+    uint64_t length;
+};
+
+TilesFramework::RingBuffer::RingBuffer(const string &path)
+    : m_map(nullptr), m_map_size(0)
+{
+    int fd = open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0)
+        return;
 
-        fragment_start += fragment_size;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > (off_t) RING_DATA_OFFSET)
+    {
+        void *map = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED, fd, 0);
+        if (map != MAP_FAILED)
+        {
+            m_map = (char *) map;
+            m_map_size = st.st_size;
+        }
     }
-    m_msg_buf.clear();
-    m_need_flush = true;
+    close(fd);
+
+    const ring_header *header = (const ring_header *) m_map;
+    if (m_map && (memcmp(header->magic, RING_MAGIC, sizeof(RING_MAGIC))
+                  || header->size != m_map_size - RING_DATA_OFFSET))
+    {
+        munmap(m_map, m_map_size);
+        m_map = nullptr;
+    }
+}
+
+TilesFramework::RingBuffer::~RingBuffer()
+{
+    if (m_map)
+        munmap(m_map, m_map_size);
+}
+
+void TilesFramework::RingBuffer::_copy_in(uint64_t pos, const void *src,
+                                          size_t len)
+{
+    const size_t size = m_map_size - RING_DATA_OFFSET;
+    char *data = m_map + RING_DATA_OFFSET;
+    const size_t start = pos % size;
+    const size_t first = min(len, size - start);
+    memcpy(data + start, src, first);
+    memcpy(data, (const char *) src + first, len - first);
+}
+
+/**
+ * Copy a message into the ring, if there is room for it.
+ *
+ * @param[out] pos where the message's record starts, for its notice.
+ */
+bool TilesFramework::RingBuffer::write(const string &msg, uint64_t &pos)
+{
+    ring_header *header = (ring_header *) m_map;
+    const size_t size = m_map_size - RING_DATA_OFFSET;
+    const uint64_t write_pos = header->write_pos;
+    const uint64_t read_pos = __atomic_load_n(&header->read_pos,
+                                              __ATOMIC_ACQUIRE);
+    const uint64_t used = write_pos - read_pos;
+    const uint64_t needed = sizeof(ring_record) + msg.size();
+    if (used > size || needed > size - used)
+        return false;
+
+    const ring_record record = { write_pos, msg.size() };
+    _copy_in(write_pos, &record, sizeof(record));
+    _copy_in(write_pos + sizeof(record), msg.data(), msg.size());
+
+    __atomic_store_n(&header->write_pos, write_pos + needed,
+                     __ATOMIC_RELEASE);
+    pos = write_pos;
+    return true;
+}
+
+/**
+ * The datagram telling the receiver about a message written to the ring.
+ * The receiver frees everything before the message when it reads it, so
+ * messages whose notices were dropped don't hold on to their space.
+ */
+string TilesFramework::RingBuffer::notice(uint64_t pos, size_t length) const
+{
+    return make_stringf("@%" PRIu64 " %u\n", pos, (unsigned int) length);
+}
+
+/**
+ * The datagram telling the receiver to free everything written so far,
+ * for when the notices of some messages have been dropped.
+ */
+string TilesFramework::RingBuffer::skip_notice() const
+{
+    const ring_header *header = (const ring_header *) m_map;
+    return make_stringf("@%" PRIu64 "\n", header->write_pos);
+}
+
+/**
+ * Send data to a receiver in fragments of at most m_max_msg_size bytes,
+ * stopping at the first fragment that can't be sent without blocking.
+ *
+ * @return the number of bytes sent, or -1 if the receiver has gone away.
+ */
+int TilesFramework::_send_nonblocking(const Receiver &dest, const char *data,
+                                      int size)
+{
+    int sent = 0;
+    while (sent < size)
+    {
+        const int fragment_size = min(size - sent, m_max_msg_size);
+        ssize_t retval = sendto(m_sock, data + sent, fragment_size,
+                                MSG_DONTWAIT, (sockaddr*) &dest.addr,
+                                sizeof(sockaddr_un));
+        if (retval > 0)
+        {
+            sent += retval;
+            continue;
+        }
+
+        if (retval == 0 || errno == ENOBUFS || errno == EWOULDBLOCK
+            || errno == EINTR || errno == EAGAIN)
+        {
+            break;
+        }
+        else if (errno == ECONNREFUSED || errno == ENOENT)
+            return -1;
+        else
+            die("Socket write error: %s", strerror(errno));
+    }
+    return sent;
+}
+
+void TilesFramework::_queue_message(Receiver &dest, const string &msg,
+                                    size_t sent)
+{
+    if (dest.queue_bytes + msg.size() - sent > MAX_QUEUED_BYTES)
+    {
+        // Drop the backlog. A message that is already partly sent has to be
+        // finished, or the receiver couldn't make sense of what follows.
+        if (!dest.queue.empty() && dest.front_sent)
+        {
+            dest.queue.resize(1);
+            dest.queue_bytes = dest.queue.front().size();
+        }
+        else
+        {
+            dest.queue.clear();
+            dest.queue_bytes = 0;
+            dest.front_sent = 0;
+        }
+
+        if (sent)
+        {
+            ASSERT(dest.queue.empty());
+            dest.queue.push_back(msg);
+            dest.queue_bytes = msg.size();
+            dest.front_sent = sent;
+        }
+        dest.needs_resync = true;
 #ifdef DEBUG_WEBSOCKETS
-    fprintf(stderr, "websocket: Sent %d bytes in %d fragments.\n",
-                                                initial_buf_size, fragments);
+        fprintf(stderr, "websocket: Receiver %s is too slow, will resync.\n",
+                        dest.addr.sun_path);
 #endif
+        return;
+    }
+
+    if (dest.queue.empty())
+        dest.front_sent = sent;
+    else
+        ASSERT(!sent);
+    dest.queue.push_back(msg);
+    dest.queue_bytes += msg.size();
 }
 
-void TilesFramework::send_message(const char *format, ...)
+/**
+ * Send as much of a receiver's queue as possible without blocking.
+ *
+ * @return false if the receiver has gone away.
+ */
+bool TilesFramework::_flush_queue(Receiver &dest)
 {
-    char buf[2048];
-    int len;
+    while (!dest.queue.empty())
+    {
+        const string &msg = dest.queue.front();
+        const int sent = _send_nonblocking(dest, msg.data() + dest.front_sent,
+                                           msg.size() - dest.front_sent);
+        if (sent < 0)
+            return false;
 
-    va_list argp;
-    va_start(argp, format);
-    if ((len = vsnprintf(buf, sizeof(buf), format, argp)) >= (int)sizeof(buf)
-        || len == -1)
+        dest.front_sent += sent;
+        if (dest.front_sent < msg.size())
+            break;
+
+        dest.queue_bytes -= msg.size();
+        dest.queue.pop_front();
+        dest.front_sent = 0;
+    }
+    return true;
+}
+
+/**
+ * Send what we can of all queued messages, dropping receivers that have gone
+ * away.
+ *
+ * @return whether any messages are still queued.
+ */
+bool TilesFramework::_flush_queues()
+{
+    bool pending = false;
+    for (unsigned int i = 0; i < m_dests.size(); ++i)
     {
-        if (len == -1)
-            die("Webtiles message format error! (%s)", format);
-        else
-            die("Webtiles message too long! (%d)", len);
+        if (!_flush_queue(m_dests[i]))
+        {
+            m_dests.erase(m_dests.begin() + i);
+            i--;
+            continue;
+        }
+        pending |= !m_dests[i].queue.empty();
     }
-    va_end(argp);
+    return pending;
+}
+
+/**
+ * Send the complete game state to any receivers that overflowed their queue
+ * and have since caught up. Like a spectator join, this is only safe while
+ * waiting for input, when nothing is left to redraw.
+ */
+void TilesFramework::_resync_receivers()
+{
+    for (unsigned int i = 0; i < m_dests.size(); ++i)
+    {
+        if (!m_dests[i].needs_resync || !m_dests[i].queue.empty())
+            continue;
+
+        Receiver &dest = m_dests[i];
+        dest.needs_resync = false;
+        // Notices of messages in the ring may have been dropped with the
+        // backlog, so the receiver can't tell on its own that their space
+        // is free again.
+        if (dest.ring)
+            _queue_message(dest, dest.ring->skip_notice(), 0);
+
+        unwind_var<string> sole(m_sole_receiver, dest.addr.sun_path);
+        _send_keyframe();
+        flush_messages();
+    }
+}
+
+void TilesFramework::_start_message_timer()
+{
+    m_msg_start_usec = get_microseconds();
+}
 
-    m_msg_buf.append(buf);
+/**
+ * Find the counters for a message's type.
+ */
+TilesFramework::MessageStats &TilesFramework::_message_stats(const string &msg)
+{
+    return m_msg_stats[_message_type(msg)];
+}
+
+/**
+ * Send the message counters to the server, which logs them.
+ */
+void TilesFramework::_send_stats()
+{
+    write_message("*{\"msg\":\"stats\",\"types\":{");
+    for (const auto &entry : m_msg_stats)
+    {
+        const MessageStats &stats = entry.second;
+        json_open_object(entry.first);
+        json_write_int("messages", stats.messages);
+        json_write_name("bytes");
+        write_message("%" PRIu64, stats.bytes);
+        json_write_int("fragments", stats.fragments);
+        json_write_int("retries", stats.retries);
+        json_write_name("serialise_usec");
+        write_message("%" PRIu64, stats.serialise_usec);
+        json_close_object();
+    }
+    write_message("}}");
+    finish_message();
+}
+
+void TilesFramework::send_message(const char *format, ...)
+{
+    va_list argp;
+    va_start(argp, format);
+    _write_message_v(format, argp);
+    va_end(argp);
 
     finish_message();
 }
@@ -306,7 +736,7 @@ void TilesFramework::_await_connection()
     if (m_sock_name.empty())
         return;
 
-    while (m_dest_addrs.size() == 0)
+    while (m_dests.size() == 0)
         _receive_control_message();
 }
 
@@ -359,7 +789,25 @@ wint_t TilesFramework::_handle_control_message(sockaddr_un addr, string data)
         JsonWrapper primary = json_find_member(obj.node, "primary");
         primary.check(JSON_BOOL);
 
-        m_dest_addrs.push_back(addr);
+        Receiver dest;
+        dest.addr = addr;
+        dest.queue_bytes = 0;
+        dest.front_sent = 0;
+        dest.needs_resync = false;
+
+        // A receiver may ask for large messages to be passed through a
+        // shared ring buffer file instead.
+        JsonWrapper ring = json_find_member(obj.node, "ring");
+        if (ring.node && ring->tag == JSON_STRING)
+        {
+            dest.ring = make_shared<RingBuffer>(ring->string_);
+            if (!dest.ring->valid())
+            {
+                dprf("Couldn't map webtiles ring buffer %s", ring->string_);
+                dest.ring.reset();
+            }
+        }
+        m_dests.push_back(dest);
         m_controlled_from_web = primary->bool_;
     }
     else if (msgtype == "key")
@@ -372,9 +820,17 @@ wint_t TilesFramework::_handle_control_message(sockaddr_un addr, string data)
     else if (msgtype == "spectator_joined")
     {
         flush_messages();
-        _send_everything();
+        {
+            unwind_var<string> sole(m_sole_receiver, addr.sun_path);
+            _send_keyframe();
+        }
         flush_messages();
     }
+    else if (msgtype == "request_stats")
+    {
+        unwind_var<string> sole(m_sole_receiver, addr.sun_path);
+        _send_stats();
+    }
     else if (msgtype == "menu_scroll")
     {
         JsonWrapper first = json_find_member(obj.node, "first");
@@ -441,6 +897,7 @@ bool TilesFramework::await_input(wint_t& c, bool block)
 
     while (true)
     {
+        bool pending = false;
         do
         {
             FD_ZERO(&fds);
@@ -448,24 +905,44 @@ bool TilesFramework::await_input(wint_t& c, bool block)
             if (!m_sock_name.empty())
                 FD_SET(m_sock, &fds);
 
+            pending = _flush_queues();
+
             if (block)
             {
+                // Send any frame held back while running.
+                if (m_frame_pending)
+                {
+                    unwind_var<int> no_coalescing(Options.tile_runrest_rate, 0);
+                    redraw();
+                }
                 tiles.flush_messages();
-                result = select(maxfd + 1, &fds, nullptr, nullptr, nullptr);
+                if (!pending)
+                {
+                    _resync_receivers();
+                    _refresh_keyframe();
+                    pending = _flush_queues();
+                }
             }
-            else
-            {
-                timeval timeout;
-                timeout.tv_sec = 0;
-                timeout.tv_usec = 0;
 
-                result = select(maxfd + 1, &fds, nullptr, nullptr, &timeout);
-            }
+            timeval timeout;
+            timeout.tv_sec = 0;
+            timeout.tv_usec = 0;
+            // Datagram sockets don't become writable when the receiver
+            // catches up, so poll while messages are queued.
+            if (block && pending)
+                timeout.tv_usec = 20 * 1000;
+
+            result = select(maxfd + 1, &fds, nullptr, nullptr,
+                            block && !pending ? nullptr : &timeout);
         }
         while (result == -1 && errno == EINTR);
 
         if (result == 0)
+        {
+            if (block)
+                continue;
             return false;
+        }
         else if (result > 0)
         {
             if (!m_sock_name.empty() && FD_ISSET(m_sock, &fds))
@@ -822,9 +1299,32 @@ player_info::player_info()
 {
     for (auto &eq : equip)
         eq = -1;
+    inv_fingerprint.init(0);
     position = coord_def(-1, -1);
 }
 
+/**
+ * A hash of everything get_item_info() takes from an inventory item, so that
+ * unchanged slots can be skipped without building their item_info.
+ * Items with properties, such as artefacts, are always compared in full,
+ * since which of their properties are known can't be cheaply told apart.
+ *
+ * @return the fingerprint, or 0 for items that have to be compared in full.
+ */
+static uint64_t _item_fingerprint(const item_def &item)
+{
+    if (!item.props.empty())
+        return 0;
+
+    uint64_t hash = hash3(item.base_type, item.sub_type, item.quantity);
+    hash = hash3(hash, item.plus, item.plus2);
+    hash = hash3(hash, item.special, item.flags);
+    hash = hash3(hash, item.rnd, item.orig_monnum);
+    hash = hash3(hash, item.defined() && item_type_known(item),
+                 hash32(item.inscription.data(), item.inscription.size()));
+    return hash | 1;
+}
+
 /**
  * Send the player properties to the webserver. Any player properties that
  * must be available to the WebTiles client must be sent here through an
@@ -961,6 +1461,14 @@ void TilesFramework::_send_player(bool force_full)
     json_open_object("inv");
     for (unsigned int i = 0; i < ENDOFPACK; ++i)
     {
+        const uint64_t fingerprint = _item_fingerprint(you.inv[i]);
+        if (!force_full && fingerprint
+            && fingerprint == c.inv_fingerprint[i])
+        {
+            continue;
+        }
+        c.inv_fingerprint[i] = fingerprint;
+
         json_open_object(to_string(i));
         _send_item(c.inv[i], get_item_info(you.inv[i]), force_full);
         json_close_object(true);
@@ -1227,16 +1735,25 @@ void TilesFramework::_send_cell(const coord_def &gc,
                                 bool force_full)
 {
     if (current_mc.feat() != next_mc.feat())
-        json_write_int("f", next_mc.feat());
+    {
+        _write_cell_field(CF_FEAT);
+        json_write_int(next_mc.feat());
+    }
 
     if (next_mc.monsterinfo())
         _send_monster(gc, next_mc.monsterinfo(), new_monster_locs, force_full);
     else if (current_mc.monsterinfo())
-        json_write_null("mon");
+    {
+        _write_cell_field(CF_MON);
+        json_write_null();
+    }
 
     map_feature mf = get_cell_map_feature(gc);
     if (get_cell_map_feature(current_mc) != mf)
-        json_write_int("mf", mf);
+    {
+        _write_cell_field(CF_MAP_FEAT);
+        json_write_int(mf);
+    }
 
     // Glyph and colour
     char32_t glyph = next_sc.glyph;
@@ -1244,17 +1761,20 @@ void TilesFramework::_send_cell(const coord_def &gc,
     {
         char buf[5];
         buf[wctoutf8(buf, glyph)] = 0;
-        json_write_string("g", buf);
+        _write_cell_field(CF_GLYPH);
+        json_write_string(buf);
     }
     if ((current_sc.colour != next_sc.colour
          || current_sc.glyph == ' ') && glyph != ' ')
     {
         int col = next_sc.colour;
         col = (_get_brand(col) << 4) | macro_colour(col & 0xF);
-        json_write_int("col", col);
+        _write_cell_field(CF_COL);
+        json_write_int(col);
     }
 
-    json_open_object("t");
+    if (!m_compact_cells)
+        json_open_object("t");
     {
         // Tile data
         const packed_cell &next_pc = next_sc.tile;
@@ -1269,68 +1789,116 @@ void TilesFramework::_send_cell(const coord_def &gc,
         {
             fg_changed = true;
 
-            json_write_name("fg");
+            _write_cell_field(CF_FG);
             write_tileidx(next_pc.fg);
             if (fg_idx && fg_idx <= TILE_MAIN_MAX)
-                json_write_int("base", (int) tileidx_known_base_item(fg_idx));
+            {
+                _write_cell_field(CF_BASE);
+                json_write_int((int) tileidx_known_base_item(fg_idx));
+            }
         }
 
         if (next_pc.bg != current_pc.bg)
         {
-            json_write_name("bg");
+            _write_cell_field(CF_BG);
             write_tileidx(next_pc.bg);
         }
 
         if (next_pc.cloud != current_pc.cloud)
         {
-            json_write_name("cloud");
+            _write_cell_field(CF_CLOUD);
             write_tileidx(next_pc.cloud);
         }
 
         if (next_pc.is_bloody != current_pc.is_bloody)
-            json_write_bool("bloody", next_pc.is_bloody);
+        {
+            _write_cell_field(CF_BLOODY);
+            json_write_bool(next_pc.is_bloody);
+        }
 
         if (next_pc.old_blood != current_pc.old_blood)
-            json_write_bool("old_blood", next_pc.old_blood);
+        {
+            _write_cell_field(CF_OLD_BLOOD);
+            json_write_bool(next_pc.old_blood);
+        }
 
         if (next_pc.is_silenced != current_pc.is_silenced)
-            json_write_bool("silenced", next_pc.is_silenced);
+        {
+            _write_cell_field(CF_SILENCED);
+            json_write_bool(next_pc.is_silenced);
+        }
 
         if (next_pc.halo != current_pc.halo)
-            json_write_int("halo", next_pc.halo);
+        {
+            _write_cell_field(CF_HALO);
+            json_write_int(next_pc.halo);
+        }
 
         if (next_pc.is_moldy != current_pc.is_moldy)
-            json_write_bool("moldy", next_pc.is_moldy);
+        {
+            _write_cell_field(CF_MOLDY);
+            json_write_bool(next_pc.is_moldy);
+        }
 
         if (next_pc.glowing_mold != current_pc.glowing_mold)
-            json_write_bool("glowing_mold", next_pc.glowing_mold);
+        {
+            _write_cell_field(CF_GLOWING_MOLD);
+            json_write_bool(next_pc.glowing_mold);
+        }
 
         if (next_pc.is_sanctuary != current_pc.is_sanctuary)
-            json_write_bool("sanctuary", next_pc.is_sanctuary);
+        {
+            _write_cell_field(CF_SANCTUARY);
+            json_write_bool(next_pc.is_sanctuary);
+        }
 
         if (next_pc.is_liquefied != current_pc.is_liquefied)
-            json_write_bool("liquefied", next_pc.is_liquefied);
+        {
+            _write_cell_field(CF_LIQUEFIED);
+            json_write_bool(next_pc.is_liquefied);
+        }
 
         if (next_pc.orb_glow != current_pc.orb_glow)
-            json_write_int("orb_glow", next_pc.orb_glow);
+        {
+            _write_cell_field(CF_ORB_GLOW);
+            json_write_int(next_pc.orb_glow);
+        }
 
         if (next_pc.quad_glow != current_pc.quad_glow)
-            json_write_bool("quad_glow", next_pc.quad_glow);
+        {
+            _write_cell_field(CF_QUAD_GLOW);
+            json_write_bool(next_pc.quad_glow);
+        }
 
         if (next_pc.disjunct != current_pc.disjunct)
-            json_write_bool("disjunct", next_pc.disjunct);
+        {
+            _write_cell_field(CF_DISJUNCT);
+            json_write_bool(next_pc.disjunct);
+        }
 
         if (next_pc.mangrove_water != current_pc.mangrove_water)
-            json_write_bool("mangrove_water", next_pc.mangrove_water);
+        {
+            _write_cell_field(CF_MANGROVE_WATER);
+            json_write_bool(next_pc.mangrove_water);
+        }
 
         if (next_pc.awakened_forest != current_pc.awakened_forest)
-            json_write_bool("awakened_forest", next_pc.awakened_forest);
+        {
+            _write_cell_field(CF_AWAKENED_FOREST);
+            json_write_bool(next_pc.awakened_forest);
+        }
 
         if (next_pc.blood_rotation != current_pc.blood_rotation)
-            json_write_int("blood_rotation", next_pc.blood_rotation);
+        {
+            _write_cell_field(CF_BLOOD_ROTATION);
+            json_write_int(next_pc.blood_rotation);
+        }
 
         if (next_pc.travel_trail != current_pc.travel_trail)
-            json_write_int("travel_trail", next_pc.travel_trail);
+        {
+            _write_cell_field(CF_TRAVEL_TRAIL);
+            json_write_int(next_pc.travel_trail);
+        }
 
         if (_needs_flavour(next_pc) &&
             (next_pc.flv.floor != current_pc.flv.floor
@@ -1338,13 +1906,18 @@ void TilesFramework::_send_cell(const coord_def &gc,
              || !_needs_flavour(current_pc)
              || force_full))
         {
-            json_open_object("flv");
+            _open_cell_object(CF_FLV);
             json_write_int("f", next_pc.flv.floor);
             if (next_pc.flv.special)
                 json_write_int("s", next_pc.flv.special);
-            json_close_object();
+            _close_cell_object(CF_FLV, false);
         }
 
+        // In the compact encoding, the doll and mcache are written as an
+        // object whose members are merged into the tile data.
+        if (m_compact_cells)
+            _open_cell_object(CF_DOLL);
+
         if (fg_idx >= TILEP_MCACHE_START)
         {
             if (fg_changed)
@@ -1419,6 +1992,9 @@ void TilesFramework::_send_cell(const coord_def &gc,
             }
         }
 
+        if (m_compact_cells)
+            _close_cell_object(CF_DOLL, true);
+
         bool overlays_changed = false;
 
         if (next_pc.num_dngn_overlay != current_pc.num_dngn_overlay)
@@ -1437,15 +2013,57 @@ void TilesFramework::_send_cell(const coord_def &gc,
 
         if (overlays_changed)
         {
-            json_open_array("ov");
+            _write_cell_field(CF_OVERLAYS);
+            json_open_array();
             for (int i = 0; i < next_pc.num_dngn_overlay; ++i)
                 json_write_int(next_pc.dngn_overlay[i]);
             json_close_array();
         }
     }
-    json_close_object(true);
+    if (!m_compact_cells)
+        json_close_object(true);
+}
+
+static const char *cell_field_names[] =
+{
+    "f", "mon", "mf", "g", "col",
+    "fg", "base", "bg", "cloud", "bloody", "old_blood", "silenced", "halo",
+    "moldy", "glowing_mold", "sanctuary", "liquefied", "orb_glow",
+    "quad_glow", "disjunct", "mangrove_water", "awakened_forest",
+    "blood_rotation", "travel_trail", "flv", "doll", "ov",
+};
+/**
+ * Start writing a field of a map cell. In the verbose encoding this writes
+ * the field's name; in the compact encoding the field is instead marked in
+ * the cell's bitmask.
+ */
+void TilesFramework::_write_cell_field(cell_field field)
+{
+    COMPILE_CHECK(ARRAYSZ(cell_field_names) == NUM_CELL_FIELDS);
+
+    if (m_compact_cells)
+    {
+        json_write_comma();
+        m_cell_bits |= 1U << field;
+    }
+    else
+        json_write_name(cell_field_names[field]);
 }
 
+void TilesFramework::_open_cell_object(cell_field field)
+{
+    json_open_object(m_compact_cells ? "" : cell_field_names[field]);
+}
+
+void TilesFramework::_close_cell_object(cell_field field, bool erase_if_empty)
+{
+    const int start = m_json_stack.back().start;
+    json_close_object(erase_if_empty);
+    if (m_compact_cells && (int) m_msg_buf.size() != start)
+        m_cell_bits |= 1U << field;
+}
+
+
 void TilesFramework::_send_cursor(cursor_type type)
 {
     if (m_cursor[type] == NO_CURSOR)
@@ -1528,7 +2146,14 @@ void TilesFramework::_send_map(bool force_full)
     coord_def last_gc(0, 0);
     bool send_gc = true;
 
-    json_open_array("cells");
+    // The compact encoding ("cz") replaces the array of cell objects with a
+    // flat array of cells, each an array of the values of its changed fields
+    // followed by a bitmask of cell_field saying which fields were sent.
+    // A cell is placed right of the previous one, unless it is preceded by
+    // a pair of plain integers giving its coordinates.
+    m_compact_cells = Options.tile_web_compact_map;
+
+    json_open_array(m_compact_cells ? "cz" : "cells");
     for (int y = 0; y < GYM; y++)
         for (int x = 0; x < GXM; x++)
         {
@@ -1551,14 +2176,30 @@ void TilesFramework::_send_map(bool force_full)
             if (m_origin.equals(-1, -1))
                 m_origin = gc;
 
-            json_open_object();
-            if (send_gc
-                || last_gc.x + 1 != gc.x
-                || last_gc.y != gc.y)
+            const bool send_pos = send_gc
+                                  || last_gc.x + 1 != gc.x
+                                  || last_gc.y != gc.y;
+            const int cell_start = m_msg_buf.size();
+
+            if (m_compact_cells)
             {
-                json_write_int("x", x - m_origin.x);
-                json_write_int("y", y - m_origin.y);
-                json_treat_as_empty();
+                if (send_pos)
+                {
+                    json_write_int(x - m_origin.x);
+                    json_write_int(y - m_origin.y);
+                }
+                m_cell_bits = 0;
+                json_open_array();
+            }
+            else
+            {
+                json_open_object();
+                if (send_pos)
+                {
+                    json_write_int("x", x - m_origin.x);
+                    json_write_int("y", y - m_origin.y);
+                    json_treat_as_empty();
+                }
             }
 
             const screen_cell_t& sc = force_full ? default_cell
@@ -1571,6 +2212,20 @@ void TilesFramework::_send_map(bool force_full)
                        mc, env.map_knowledge(gc),
                        new_monster_locs, force_full);
 
+            if (m_compact_cells)
+            {
+                if (m_cell_bits)
+                {
+                    json_write_int(m_cell_bits);
+                    send_gc = false;
+                    last_gc = gc;
+                }
+                json_close_array(true);
+                if (!m_cell_bits)
+                    m_msg_buf.resize(cell_start);
+                continue;
+            }
+
             if (!json_is_empty())
             {
                 send_gc = false;
@@ -1579,6 +2234,7 @@ void TilesFramework::_send_map(bool force_full)
             json_close_object(true);
         }
     json_close_array(true);
+    m_compact_cells = false;
 
     json_close_object(true);
 
@@ -1603,7 +2259,7 @@ void TilesFramework::_send_monster(const coord_def &gc, const monster_info* m,
                                    map<uint32_t, coord_def>& new_monster_locs,
                                    bool force_full)
 {
-    json_open_object("mon");
+    _open_cell_object(CF_MON);
     if (m->client_id)
     {
         json_write_int("id", m->client_id);
@@ -1662,7 +2318,7 @@ void TilesFramework::_send_monster(const coord_def &gc, const monster_info* m,
     if (m->is_named())
         json_write_int("clientid", m->client_id);
 
-    json_close_object(true);
+    _close_cell_object(CF_MON, true);
 }
 
 void TilesFramework::load_dungeon(const crawl_view_buffer &vbuf,
@@ -1745,6 +2401,85 @@ void TilesFramework::_send_messages()
     webtiles_send_messages();
 }
 
+/**
+ * Generate the complete state into the keyframe.
+ *
+ * @param send whether to send it to the receivers too. If not, the clients
+ *             must already have been sent everything, or they would miss
+ *             whatever the full state covers.
+ */
+void TilesFramework::_record_keyframe(bool send)
+{
+    m_keyframe.clear();
+    m_keyframe_bytes = 0;
+    {
+        unwind_bool recording(m_recording_keyframe, true);
+        unwind_bool keyframe_only(m_keyframe_only, !send);
+        _send_everything();
+    }
+    m_keyframe_state_bytes = m_keyframe_bytes;
+    m_keyframe_valid = true;
+}
+
+/**
+ * Send everything a newly joined spectator needs, replaying the keyframe if
+ * there is one. Only m_sole_receiver is sent it, if that is set.
+ */
+void TilesFramework::_send_keyframe()
+{
+    // New game messages are only ever sent once, so they mustn't be part of
+    // the keyframe; they go to everyone.
+    {
+        unwind_var<string> everyone(m_sole_receiver, "");
+        _send_messages();
+    }
+
+    if (m_keyframe_valid)
+    {
+#ifdef DEBUG_WEBSOCKETS
+        fprintf(stderr, "websocket: Replaying %u keyframe messages.\n",
+                        (unsigned int) m_keyframe.size());
+#endif
+        for (const string &msg : m_keyframe)
+            _send_to_receivers(msg, _message_stats(msg));
+        m_need_flush = true;
+        return;
+    }
+
+    _record_keyframe(true);
+}
+
+/**
+ * Generate the keyframe again if the messages added to it since have grown
+ * too large, so that replaying it stays cheap. This must only be called
+ * while waiting for input, after everything has been sent.
+ */
+void TilesFramework::_refresh_keyframe()
+{
+    if (!m_keyframe_valid
+        || m_keyframe_bytes - m_keyframe_state_bytes
+           <= KEYFRAME_REFRESH_GROWTH * m_keyframe_state_bytes)
+    {
+        return;
+    }
+
+    // Make sure the clients are up to date, so that nothing is only in the
+    // silently generated state.
+    {
+        unwind_var<int> no_coalescing(Options.tile_runrest_rate, 0);
+        redraw();
+    }
+    _send_messages();
+    if (m_need_redraw || m_need_full_map)
+        return;
+
+#ifdef DEBUG_WEBSOCKETS
+    fprintf(stderr, "websocket: Refreshing keyframe (%u bytes).\n",
+                    (unsigned int) m_keyframe_bytes);
+#endif
+    _record_keyframe(false);
+}
+
 /*
   Send everything a newly joined spectator needs
  */
@@ -1842,6 +2577,19 @@ void TilesFramework::cgotoxy(int x, int y, GotoRegion region)
     m_cursor_region = region;
 }
 
+/**
+ * Whether to hold back the next frame. While running or resting, the changes
+ * of consecutive turns are coalesced into at most one frame every
+ * tile_runrest_rate milliseconds; the final state is sent when we wait for
+ * input.
+ */
+bool TilesFramework::_coalesce_frame() const
+{
+    return you.running && Options.tile_runrest_rate > 0
+           && get_milliseconds() - m_last_tick_redraw
+              < (unsigned int) Options.tile_runrest_rate;
+}
+
 void TilesFramework::redraw()
 {
     if (!has_receivers())
@@ -1854,6 +2602,13 @@ void TilesFramework::redraw()
         return;
     }
 
+    if (_coalesce_frame())
+    {
+        m_frame_pending = true;
+        return;
+    }
+    m_frame_pending = false;
+
     if (m_layout_reset)
     {
         _send_layout();
@@ -1996,10 +2751,10 @@ void TilesFramework::clear_overlays()
 
 void TilesFramework::set_need_redraw(unsigned int min_tick_delay)
 {
-    unsigned int ticks = (get_milliseconds() - m_last_tick_redraw);
-    if (min_tick_delay && ticks <= min_tick_delay)
-        return;
-
+    // Unlike local tiles, we always note the need to redraw: redraw() itself
+    // limits the frame rate, and skipping the request here could leave the
+    // client with a stale map once running stops.
+    UNUSED(min_tick_delay);
     m_need_redraw = true;
 }
 
@@ -2094,36 +2849,56 @@ bool TilesFramework::cell_needs_redraw(const coord_def& gc)
 
 void TilesFramework::write_message_escaped(const string& s)
 {
-    m_msg_buf.reserve(m_msg_buf.size() + s.size());
+    _write_message_escaped(s.data(), s.size());
+}
 
-    for (unsigned char c : s)
+/**
+ * Append a string with JSON escaping. Runs of characters that need no
+ * escaping are copied at once.
+ */
+void TilesFramework::_write_message_escaped(const char *s, size_t len)
+{
+    static const char hex_digits[] = "0123456789abcdef";
+
+    const char *end = s + len;
+    const char *run = s;
+    for (; s < end; ++s)
     {
+        const unsigned char c = *s;
+        if (c >= 0x20 && c != '"' && c != '\\')
+            continue;
+
+        m_msg_buf.append(run, s - run);
+        run = s + 1;
+
         if (c == '"')
-            m_msg_buf.append("\\\"");
+            m_msg_buf.append("\\\"", 2);
         else if (c == '\\')
-            m_msg_buf.append("\\\\");
-        else if (c < 0x20)
+            m_msg_buf.append("\\\\", 2);
+        else
         {
-            char buf[7];
-            snprintf(buf, sizeof(buf), "\\u%04x", c);
-            m_msg_buf.append(buf);
+            const char esc[] = { '\\', 'u', '0', '0',
+                                 hex_digits[c >> 4], hex_digits[c & 0xf] };
+            m_msg_buf.append(esc, sizeof(esc));
         }
-        else
-            m_msg_buf.append(1, c);
     }
+    m_msg_buf.append(run, end - run);
 }
 
-void TilesFramework::json_open(const string& name, char opener, char type)
+void TilesFramework::json_open(const char *name, char opener, char type)
 {
     m_json_stack.resize(m_json_stack.size() + 1);
     JsonFrame& fr = m_json_stack.back();
     fr.start = m_msg_buf.size();
 
+    if (m_msg_buf.empty())
+        _start_message_timer();
+
     json_write_comma();
-    if (!name.empty())
+    if (name && *name)
         json_write_name(name);
 
-    m_msg_buf.append(1, opener);
+    m_msg_buf.push_back(opener);
 
     fr.prefix_end = m_msg_buf.size();
     fr.type = type;
@@ -2158,28 +2933,47 @@ void TilesFramework::json_close(bool erase_if_empty, char type)
         die("json error: attempting to close wrong type");
 
     if (erase_if_empty && json_is_empty())
+    {
+        // Still count the time spent on messages that turned out empty.
+        if (m_json_stack.back().start == 0 && m_msg_start_usec)
+        {
+            _message_stats(m_msg_buf).serialise_usec
+                += get_microseconds() - m_msg_start_usec;
+            m_msg_start_usec = 0;
+        }
         m_msg_buf.resize(m_json_stack.back().start);
+    }
     else
-        m_msg_buf.append(1, type);
+        m_msg_buf.push_back(type);
 
     m_json_stack.pop_back();
 }
 
-void TilesFramework::json_open_object(const string& name)
+void TilesFramework::json_open_object(const char *name)
 {
     json_open(name, '{', '}');
 }
 
+void TilesFramework::json_open_object(const string& name)
+{
+    json_open(name.c_str(), '{', '}');
+}
+
 void TilesFramework::json_close_object(bool erase_if_empty)
 {
     json_close(erase_if_empty, '}');
 }
 
-void TilesFramework::json_open_array(const string& name)
+void TilesFramework::json_open_array(const char *name)
 {
     json_open(name, '[', ']');
 }
 
+void TilesFramework::json_open_array(const string& name)
+{
+    json_open(name.c_str(), '[', ']');
+}
+
 void TilesFramework::json_close_array(bool erase_if_empty)
 {
     json_close(erase_if_empty, ']');
@@ -2190,23 +2984,53 @@ void TilesFramework::json_write_comma()
     if (m_msg_buf.empty()) return;
     char last = m_msg_buf[m_msg_buf.size() - 1];
     if (last == '{' || last == '[' || last == ',' || last == ':') return;
-    write_message(",");
+    m_msg_buf.push_back(',');
+}
+
+void TilesFramework::json_write_name(const char *name)
+{
+    json_write_comma();
+
+    m_msg_buf.push_back('"');
+    _write_message_escaped(name, strlen(name));
+    m_msg_buf.append("\":", 2);
 }
 
 void TilesFramework::json_write_name(const string& name)
 {
     json_write_comma();
 
-    write_message("\"");
-    write_message_escaped(name);
-    write_message("\":");
+    m_msg_buf.push_back('"');
+    _write_message_escaped(name.data(), name.size());
+    m_msg_buf.append("\":", 2);
 }
 
 void TilesFramework::json_write_int(int value)
 {
     json_write_comma();
 
-    write_message("%d", value);
+    // Written backwards from the end of the buffer.
+    char buf[12];
+    char *p = buf + sizeof(buf);
+    unsigned int u = value < 0 ? 0u - (unsigned int) value : value;
+    do
+    {
+        *--p = '0' + u % 10;
+        u /= 10;
+    }
+    while (u);
+    if (value < 0)
+        *--p = '-';
+
+    m_msg_buf.append(p, buf + sizeof(buf) - p);
+}
+
+void TilesFramework::json_write_int(const char *name, int value)
+{
+    if (*name)
+        json_write_name(name);
+
+    json_write_int(value);
 }
 
 void TilesFramework::json_write_int(const string& name, int value)
@@ -2222,9 +3046,17 @@ void TilesFramework::json_write_bool(bool value)
     json_write_comma();
 
     if (value)
-        write_message("true");
+        m_msg_buf.append("true", 4);
     else
-        write_message("false");
+        m_msg_buf.append("false", 5);
+}
+
+void TilesFramework::json_write_bool(const char *name, bool value)
+{
+    if (*name)
+        json_write_name(name);
+
+    json_write_bool(value);
 }
 
 void TilesFramework::json_write_bool(const string& name, bool value)
@@ -2239,7 +3071,15 @@ void TilesFramework::json_write_null()
 {
     json_write_comma();
 
-    write_message("null");
+    m_msg_buf.append("null", 4);
+}
+
+void TilesFramework::json_write_null(const char *name)
+{
+    if (*name)
+        json_write_name(name);
+
+    json_write_null();
 }
 
 void TilesFramework::json_write_null(const string& name)
@@ -2250,13 +3090,28 @@ void TilesFramework::json_write_null(const string& name)
     json_write_null();
 }
 
+void TilesFramework::json_write_raw(const string& value)
+{
+    json_write_comma();
+
+    m_msg_buf.append(value);
+}
+
 void TilesFramework::json_write_string(const string& value)
 {
     json_write_comma();
 
-    write_message("\"");
-    write_message_escaped(value);
-    write_message("\"");
+    m_msg_buf.push_back('"');
+    _write_message_escaped(value.data(), value.size());
+    m_msg_buf.push_back('"');
+}
+
+void TilesFramework::json_write_string(const char *name, const string& value)
+{
+    if (*name)
+        json_write_name(name);
+
+    json_write_string(value);
 }
 
 void TilesFramework::json_write_string(const string& name, const string& value)
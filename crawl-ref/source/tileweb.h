@@ -8,7 +8,10 @@
 #ifdef USE_TILE_WEB
 
 #include <bitset>
+#include <cstdarg>
+#include <deque>
 #include <map>
+#include <memory>
 #include <sys/un.h>
 
 #include "cursor-type.h"
@@ -75,6 +78,8 @@ struct player_info
     vector<status_info> status;
 
     FixedVector<item_info, ENDOFPACK> inv;
+    // _item_fingerprint() of the items inv was last updated from
+    FixedVector<uint64_t, ENDOFPACK> inv_fingerprint;
     FixedVector<int8_t, NUM_EQUIP> equip;
     int8_t quiver_item;
     string unarmed_attack;
@@ -149,7 +154,7 @@ public:
     void send_message(PRINTF(1, ));
     void flush_messages();
 
-    bool has_receivers() { return !m_dest_addrs.empty(); }
+    bool has_receivers() { return !m_dests.empty(); }
     bool is_controlled_from_web() { return m_controlled_from_web; }
 
     /* Webtiles can receive input both via stdin, and on the
@@ -173,19 +178,28 @@ public:
 
     // Helper functions for writing JSON
     void write_message_escaped(const string& s);
-    void json_open_object(const string& name = "");
+    // The overloads taking a C string are for constant names, so that those
+    // don't have to be turned into std::strings first.
+    void json_open_object(const char *name = nullptr);
+    void json_open_object(const string& name);
     void json_close_object(bool erase_if_empty = false);
-    void json_open_array(const string& name = "");
+    void json_open_array(const char *name = nullptr);
+    void json_open_array(const string& name);
     void json_close_array(bool erase_if_empty = false);
     void json_write_comma();
+    void json_write_name(const char *name);
     void json_write_name(const string& name);
     void json_write_int(int value);
+    void json_write_int(const char *name, int value);
     void json_write_int(const string& name, int value);
     void json_write_bool(bool value);
+    void json_write_bool(const char *name, bool value);
     void json_write_bool(const string& name, bool value);
     void json_write_null();
+    void json_write_null(const char *name);
     void json_write_null(const string& name);
     void json_write_string(const string& value);
+    void json_write_string(const char *name, const string& value);
     void json_write_string(const string& name, const string& value);
     /* Causes the current object/array to be erased if it is closed
        with erase_if_empty without writing any other content after
@@ -193,6 +207,12 @@ public:
     void json_treat_as_empty();
     void json_treat_as_nonempty();
     bool json_is_empty();
+    /* For callers caching what they wrote: json_since() returns everything
+       written after json_mark() was called, and json_write_raw() writes
+       such a value again. */
+    size_t json_mark() const { return m_msg_buf.size(); }
+    string json_since(size_t mark) const { return m_msg_buf.substr(mark); }
+    void json_write_raw(const string& value);
 
     string m_sock_name;
     bool m_await_connection;
@@ -212,7 +232,86 @@ protected:
     int m_sock;
     int m_max_msg_size;
     string m_msg_buf;
-    vector<sockaddr_un> m_dest_addrs;
+    void _write_message_v(const char *format, va_list argp);
+    void _write_message_escaped(const char *s, size_t len);
+
+    // A memory-mapped file, created by a receiver, that messages too large
+    // for a single datagram are written to instead of being fragmented.
+    // The receiver is told about each one with a short notice datagram
+    // giving its position, so a lost notice only loses that message.
+    class RingBuffer
+    {
+    public:
+        RingBuffer(const string &path);
+        ~RingBuffer();
+        RingBuffer(const RingBuffer&) = delete;
+        RingBuffer& operator=(const RingBuffer&) = delete;
+
+        bool valid() const { return m_map; }
+        bool write(const string &msg, uint64_t &pos);
+        string notice(uint64_t pos, size_t length) const;
+        string skip_notice() const;
+
+    private:
+        char *m_map;
+        size_t m_map_size;
+
+        void _copy_in(uint64_t pos, const void *src, size_t len);
+    };
+
+    // A socket we send the game state to. Messages that can't be sent
+    // without blocking are queued here and sent from await_input().
+    struct Receiver
+    {
+        sockaddr_un addr;
+        shared_ptr<RingBuffer> ring;
+        deque<string> queue;
+        size_t queue_bytes;
+        size_t front_sent; // how much of queue.front() has been sent
+        bool needs_resync;
+    };
+    vector<Receiver> m_dests;
+    // If set, messages are only sent to the receiver with this path.
+    string m_sole_receiver;
+
+    int _send_nonblocking(const Receiver &dest, const char *data, int size);
+    void _queue_message(Receiver &dest, const string &msg, size_t sent);
+    bool _flush_queue(Receiver &dest);
+    // Always-on counters of what is sent, by message type. Requested with
+    // the request_stats control message, and sent to the server on exit.
+    struct MessageStats
+    {
+        unsigned int messages;
+        uint64_t bytes;
+        unsigned int fragments;
+        unsigned int retries; // sends queued because a receiver was busy
+        uint64_t serialise_usec;
+    };
+    map<string, MessageStats> m_msg_stats;
+    uint64_t m_msg_start_usec; // when the message being written was begun
+    MessageStats &_message_stats(const string &msg);
+    void _start_message_timer();
+    void _send_stats();
+
+    void _send_to_receivers(const string &msg, MessageStats &stats);
+    bool _flush_queues();
+    void _resync_receivers();
+
+    // The messages of the last complete state sent by _send_everything(),
+    // followed by the state updates sent to all clients since. Replaying
+    // these brings a joining spectator to the current state without
+    // generating it again. Any other message that changes what the clients
+    // show, such as a menu opening, drops it. Once the updates outgrow the
+    // state, it is generated afresh while waiting for input.
+    vector<string> m_keyframe;
+    size_t m_keyframe_state_bytes;
+    size_t m_keyframe_bytes;
+    bool m_keyframe_valid;
+    bool m_recording_keyframe;
+    bool m_keyframe_only; // record messages without sending them
+    void _record_keyframe(bool send);
+    void _send_keyframe();
+    void _refresh_keyframe();
 
     bool m_controlled_from_web;
     bool m_need_flush;
@@ -231,7 +330,7 @@ protected:
     };
     vector<JsonFrame> m_json_stack;
 
-    void json_open(const string& name, char opener, char type);
+    void json_open(const char *name, char opener, char type);
     void json_close(bool erase_if_empty, char type);
 
     struct UIStackFrame
@@ -309,6 +408,50 @@ protected:
 
     void _send_cursor(cursor_type type);
     void _send_map(bool force_full = false);
+
+    // Fields of a map cell, in the order of their bits in the compact map
+    // encoding (see _send_map).
+    enum cell_field
+    {
+        CF_FEAT,
+        CF_MON,
+        CF_MAP_FEAT,
+        CF_GLYPH,
+        CF_COL,
+        CF_FIRST_TILE_FIELD,
+        CF_FG = CF_FIRST_TILE_FIELD,
+        CF_BASE,
+        CF_BG,
+        CF_CLOUD,
+        CF_BLOODY,
+        CF_OLD_BLOOD,
+        CF_SILENCED,
+        CF_HALO,
+        CF_MOLDY,
+        CF_GLOWING_MOLD,
+        CF_SANCTUARY,
+        CF_LIQUEFIED,
+        CF_ORB_GLOW,
+        CF_QUAD_GLOW,
+        CF_DISJUNCT,
+        CF_MANGROVE_WATER,
+        CF_AWAKENED_FOREST,
+        CF_BLOOD_ROTATION,
+        CF_TRAVEL_TRAIL,
+        CF_FLV,
+        CF_DOLL,
+        CF_OVERLAYS,
+        NUM_CELL_FIELDS,
+    };
+    bool m_compact_cells;
+    unsigned int m_cell_bits;
+    void _write_cell_field(cell_field field);
+    void _open_cell_object(cell_field field);
+    void _close_cell_object(cell_field field, bool erase_if_empty);
+
+    bool m_frame_pending;
+    bool _coalesce_frame() const;
+
     void _send_cell(const coord_def &gc,
                     const screen_cell_t &current_sc, const screen_cell_t &next_sc,
                     const map_cell &current_mc, const map_cell &next_mc,
@@ -15,6 +15,7 @@
 #include <cstdarg>
 #include <cstdio>
 #include <memory>
+#include <queue>
 #include <set>
 #include <sstream>
 
@@ -182,6 +183,7 @@ static bool _find_transtravel_square(const level_pos &pos,
 
 static bool _loadlev_populate_stair_distances(const level_pos &target);
 static void _populate_stair_distances(const level_pos &target);
+static void _forget_target_stair_distances(const level_id &lev);
 static bool _is_greed_inducing_square(const LevelStashes *ls,
                                       const coord_def &c, bool autopickup);
 static bool _is_travelsafe_square(const coord_def& c,
@@ -513,6 +515,7 @@ static bool _is_safe_move(const coord_def& c)
 
 void travel_init_load_level()
 {
+    _forget_target_stair_distances(level_id::current());
     curr_excludes.clear();
     travel_cache.set_level_excludes();
     travel_cache.update_waypoints();
@@ -705,22 +708,23 @@ static void _set_target_square(const coord_def &target)
     you.running.pos = target;
 }
 
-static void _explore_find_target_square()
+// Works out where explore should go next, without acting on it. tp is left
+// with the results of the first flood, for _find_explore_status().
+static coord_def _explore_target(run_mode_type rmode, travel_pathfind &tp,
+                                 bool &runed_door_pause)
 {
-    bool runed_door_pause = false;
+    runed_door_pause = false;
 
-    travel_pathfind tp;
     tp.set_floodseed(you.pos(), true);
 
-    coord_def whereto =
-        tp.pathfind(static_cast<run_mode_type>(you.running.runmode));
+    coord_def whereto = tp.pathfind(rmode);
 
     // If we didn't find an explore target the first time, try fallback mode
     if (!whereto.x && !whereto.y)
     {
         travel_pathfind fallback_tp;
         fallback_tp.set_floodseed(you.pos(), true);
-        whereto = fallback_tp.pathfind(static_cast<run_mode_type>(you.running.runmode), true);
+        whereto = fallback_tp.pathfind(rmode, true);
 
         if (whereto.distance_from(you.pos()) == 1 && cell_is_runed(whereto))
         {
@@ -743,6 +747,64 @@ static void _explore_find_target_square()
         }
     }
 
+    return whereto;
+}
+
+// An explore target worked out while the game was waiting for a command.
+struct precomputed_explore_target
+{
+    bool valid;
+    level_id level;
+    coord_def pos;
+    int turn;
+    run_mode_type mode;
+    coord_def target;
+
+    precomputed_explore_target()
+        : valid(false), level(), pos(), turn(0), mode(RMODE_NOT_RUNNING),
+          target()
+    {
+    }
+};
+
+static precomputed_explore_target _precomputed_explore;
+
+void forget_explore_target()
+{
+    _precomputed_explore.valid = false;
+}
+
+// The precomputed explore target, if the explore command came right after it
+// was worked out; otherwise (0,0).
+static coord_def _take_precomputed_explore_target()
+{
+    const precomputed_explore_target &pre = _precomputed_explore;
+    const bool usable = pre.valid
+                        && Options.explore_precompute
+                        && crawl_state.prev_cmd == CMD_EXPLORE
+                        && you.running == pre.mode
+                        && pre.level == level_id::current()
+                        && pre.pos == you.pos()
+                        && pre.turn == you.num_turns;
+
+    forget_explore_target();
+    return usable ? pre.target : coord_def();
+}
+
+static void _explore_find_target_square()
+{
+    coord_def whereto = _take_precomputed_explore_target();
+    if (!whereto.origin())
+    {
+        _set_target_square(whereto);
+        return;
+    }
+
+    bool runed_door_pause;
+    travel_pathfind tp;
+    whereto = _explore_target(static_cast<run_mode_type>(you.running.runmode),
+                              tp, runed_door_pause);
+
     if (whereto.x || whereto.y)
     {
         _set_target_square(whereto);
@@ -1056,6 +1118,162 @@ static void _fill_exclude_radius(const travel_exclude &exc)
         }
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// travel_flood_cache
+
+// The travel cost of a square as seen by a travel flood: 0 if it is not safe
+// to travel over, otherwise the number of moves it takes to cross.
+static int8_t _travel_flood_cost(const coord_def &c)
+{
+    if (!_is_travelsafe_square(c))
+        return 0;
+
+    return _feature_traverse_cost(env.map_knowledge(c).feat());
+}
+
+// Remembers a travel flood from a destination, so that consecutive travel and
+// explore moves towards the same destination need not flood again. Until it
+// first examines a neighbour of the player, the flood is the same wherever
+// the player stands, so a later move can be read off the recorded order of
+// examination as long as none of the squares the flood has looked at up to
+// that point has changed its travel cost. Otherwise the flood is redone.
+class travel_flood_cache
+{
+public:
+    travel_flood_cache();
+
+    void start(const coord_def &target);
+    void examine(const coord_def &c);
+    bool find_move(const coord_def &target, const coord_def &youpos,
+                   coord_def &move);
+
+private:
+    bool unchanged(const coord_def &c);
+
+private:
+    level_id level;
+    coord_def target;
+
+    // Squares whose neighbours the flood examined, in order.
+    vector<coord_def> order;
+
+    // Index into order of the first square to examine each square, or -1.
+    FixedArray<int, GXM, GYM> examiner;
+
+    // Travel cost of each square the flood has looked at, or -1.
+    FixedArray<int8_t, GXM, GYM> cost;
+
+    // Squares already compared against cost by the current find_move().
+    FixedArray<int, GXM, GYM> checked;
+    int check_stamp;
+};
+
+static travel_flood_cache _travel_flood_cache;
+
+// Floods through transporters don't just proceed to adjacent squares, so
+// they aren't reused.
+static bool _level_has_known_transporters()
+{
+    LevelInfo *li = travel_cache.find_level_info(level_id::current());
+    return li && !li->get_transporters().empty();
+}
+
+travel_flood_cache::travel_flood_cache()
+    : level(), target(), order(), examiner(-1), cost(-1), checked(0),
+      check_stamp(0)
+{
+}
+
+// Forget the previous flood and start recording one from target.
+void travel_flood_cache::start(const coord_def &targ)
+{
+    level = level_id::current();
+    target = targ;
+    order.clear();
+    examiner.init(-1);
+    cost.init(-1);
+}
+
+// Record that the flood is examining the neighbours of c.
+void travel_flood_cache::examine(const coord_def &c)
+{
+    const int index = order.size();
+    order.push_back(c);
+
+    if (cost(c) < 0)
+        cost(c) = _travel_flood_cost(c);
+
+    for (int dir = 0; dir < 8; ++dir)
+    {
+        const coord_def dc = c + Compass[dir];
+        if (!in_bounds(dc))
+            continue;
+
+        if (examiner(dc) < 0)
+            examiner(dc) = index;
+        if (cost(dc) < 0)
+            cost(dc) = _travel_flood_cost(dc);
+    }
+}
+
+bool travel_flood_cache::unchanged(const coord_def &c)
+{
+    if (checked(c) == check_stamp)
+        return true;
+
+    checked(c) = check_stamp;
+    return cost(c) == _travel_flood_cost(c);
+}
+
+// Find the move from youpos towards target that a new flood would find.
+// Returns false if the recorded flood can't be used; otherwise move is set,
+// or reset if the move isn't safe.
+bool travel_flood_cache::find_move(const coord_def &targ,
+                                   const coord_def &youpos, coord_def &move)
+{
+    if (targ != target || youpos == target || level != level_id::current()
+        || examiner(youpos) < 0 || _level_has_known_transporters())
+    {
+        return false;
+    }
+
+    // travel_pathfind::pathfind() gives up on such destinations before
+    // flooding; leave that to it.
+    if (!_is_travelsafe_square(target, false, false, true) && !is_trap(target))
+        return false;
+
+    unwind_bool slime_wall_check(g_Slime_Wall_Check,
+                                 !actor_slime_wall_immune(&you));
+
+    if (check_stamp == INT_MAX)
+    {
+        checked.init(0);
+        check_stamp = 0;
+    }
+    ++check_stamp;
+
+    const int last = examiner(youpos);
+    for (int i = 0; i <= last; ++i)
+    {
+        const coord_def &c = order[i];
+        if (!unchanged(c))
+            return false;
+
+        for (int dir = 0; dir < 8; ++dir)
+        {
+            const coord_def dc = c + Compass[dir];
+            if (in_bounds(dc) && !unchanged(dc))
+                return false;
+        }
+    }
+
+    if (_is_safe_move(order[last]))
+        move = order[last];
+    else
+        move.reset();
+    return true;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // travel_pathfind
 
@@ -1071,7 +1289,8 @@ travel_pathfind::travel_pathfind()
       ignore_danger(false), annotate_map(false), ls(nullptr),
       need_for_greed(false), autopickup(false),
       unexplored_place(), greedy_place(), unexplored_dist(0), greedy_dist(0),
-      refdist(nullptr), reseed_points(), features(nullptr), unreachables(),
+      refdist(nullptr), reseed_points(), features(nullptr),
+      flood_cache(nullptr), unreachables(),
       point_distance(travel_point_distance), points(0), next_iter_points(0),
       traveled_distance(0), circ_index(0)
 {
@@ -1132,6 +1351,11 @@ void travel_pathfind::set_feature_vector(vector<coord_def> *feats)
     }
 }
 
+void travel_pathfind::set_flood_cache(travel_flood_cache *cache)
+{
+    flood_cache = cache;
+}
+
 const coord_def travel_pathfind::travel_move() const
 {
     return next_travel_move;
@@ -1672,6 +1896,9 @@ bool travel_pathfind::path_examine_point(const coord_def &c)
     if (point_traverse_delay(c))
         return false;
 
+    if (flood_cache)
+        flood_cache->examine(c);
+
     bool found_target = false;
 
     // For each point, we look at all surrounding points. Take them orthogonals
@@ -1749,7 +1976,20 @@ void find_travel_pos(const coord_def& youpos,
 
     run_mode_type rmode = (need_move) ? RMODE_TRAVEL : RMODE_NOT_RUNNING;
 
-    coord_def dest = tp.pathfind(rmode, false);
+    // Travel moves towards the same destination can reuse an earlier flood.
+    const bool use_cache = need_move && !features;
+    coord_def dest;
+    if (!use_cache
+        || !_travel_flood_cache.find_move(you.running.pos, youpos, dest))
+    {
+        if (use_cache)
+        {
+            _travel_flood_cache.start(you.running.pos);
+            tp.set_flood_cache(&_travel_flood_cache);
+        }
+        dest = tp.pathfind(rmode, false);
+        tp.set_flood_cache(nullptr);
+    }
     if (dest.origin())
         dest = tp.pathfind(rmode, true);
     coord_def new_dest = dest;
@@ -2639,11 +2879,46 @@ static int _target_distance_from(const coord_def &pos)
     return -1;
 }
 
+// Special values of transtravel_node::first_stair.
+static const int TRANSTRAVEL_START  = -2; // the player's position itself
+static const int TRANSTRAVEL_DIRECT = -1; // a route that takes no stairs
+
+// A place interlevel travel can get to, and the shortest known way to get
+// there from the player's position.
+struct transtravel_node
+{
+    int distance;
+
+    // The index of the stair on the player's level that the route takes
+    // first, or one of the TRANSTRAVEL_ values above. Among routes of equal
+    // length, the one starting with the earliest stair is preferred.
+    int first_stair;
+
+    level_pos pos;
+
+    // True if this is the travel target, not a place to go on from.
+    bool is_target;
+
+    pair<int, int> key() const
+    {
+        return make_pair(distance, first_stair);
+    }
+
+    bool operator > (const transtravel_node &other) const
+    {
+        return key() > other.key();
+    }
+};
+
 /*
  * Sets best_stair to the coordinates of the best stair on the player's current
- * level to take to get to the 'target' level. Should be called with 'distance'
- * set to 0, 'stair' set to (you.x_pos, you.y_pos) and 'best_distance' set to
- * -1. 'cur' should be the player's current level.
+ * level to take to get to the 'target' level. 'stair' should be the player's
+ * position and 'cur' the player's current level.
+ *
+ * The route is found with Dijkstra's algorithm over the stairs known to the
+ * travel cache: the LevelInfo of each level keeps the distances between its
+ * stairs, and taking a stair adds a fixed cost. Returns the length of the
+ * route, or -1 if there is none.
  *
  * If best_stair remains unchanged when this function returns, there is no
  * travel-safe path between the player's current level and the target level OR
@@ -2658,124 +2933,162 @@ static int _target_distance_from(const coord_def &pos)
  */
 static int _find_transtravel_stair(const level_id &cur,
                                     const level_pos &target,
-                                    int distance,
                                     // This is actually the current position
                                     // on cur, not necessarily a stair.
                                     const coord_def &stair,
                                     level_id &closest_level,
                                     int &best_level_distance,
-                                    coord_def &best_stair,
-                                    int search_depth = 0)
+                                    coord_def &best_stair)
 {
-    int local_distance = -1;
-    level_id player_level = level_id::current();
+    const level_id player_level = level_id::current();
 
-    LevelInfo &li = travel_cache.get_level_info(cur);
+    priority_queue<transtravel_node, vector<transtravel_node>,
+                   greater<transtravel_node>> queue;
 
-    // Have we reached the target level?
-    if (cur == target.id)
+    // The best key found so far for each place on the queue.
+    map<level_pos, pair<int, int>> best;
+
+    auto reach = [&](const level_pos &pos, int distance, int first_stair,
+                     bool is_target)
     {
-        // Are we in an exclude? If so, bail out. Unless it is just a stair exclusion.
-        if (is_excluded(stair, li.get_excludes()) && !is_stair_exclusion(stair))
-            return -1;
+        const transtravel_node node = { distance, first_stair, pos,
+                                        is_target };
+        if (!is_target)
+        {
+            auto it = best.find(pos);
+            if (it != best.end() && it->second <= node.key())
+                return;
+            best[pos] = node.key();
+        }
+        queue.push(node);
+    };
 
-        // If there's no target position on the target level, or we're on the
-        // target, we're home.
-        if (target.pos.x == -1 || target.pos == stair)
-            return distance;
+    reach(level_pos(cur, stair), 0, TRANSTRAVEL_START, false);
 
-        // If there *is* a target position, we need to work out our distance
-        // from it.
-        int deltadist = _target_distance_from(stair);
+    while (!queue.empty())
+    {
+        const transtravel_node node = queue.top();
+        queue.pop();
 
-        if (deltadist == -1 && cur == player_level)
+        if (node.is_target)
         {
-            // Okay, we don't seem to have a distance available to us, which
-            // means we're either (a) not standing on stairs or (b) whoever
-            // initiated interlevel travel didn't call
-            // _populate_stair_distances. Assuming we're not on stairs, that
-            // situation can arise only if interlevel travel has been triggered
-            // for a location on the same level. If that's the case, we can get
-            // the distance off the travel_point_distance matrix.
-            deltadist = travel_point_distance[target.pos.x][target.pos.y];
-            if (!deltadist && stair != target.pos)
-                deltadist = -1;
+            if (node.first_stair == TRANSTRAVEL_DIRECT)
+                best_stair = target.pos;
+            else if (node.first_stair >= 0)
+            {
+                best_stair = travel_cache.get_level_info(cur)
+                                 .get_stairs()[node.first_stair].position;
+            }
+            return node.distance;
         }
 
-        if (deltadist != -1)
-        {
-            local_distance = distance + deltadist;
-
-            // See if this is a degenerate case of interlevel travel:
-            // A degenerate case of interlevel travel decays to normal travel;
-            // we identify this by checking if:
-            // a. The current level is the target level.
-            // b. The target square is reachable from the 'current' square.
-            // c. The current square is where the player is.
-            //
-            // Note that even if this *is* degenerate, interlevel travel may
-            // still be able to find a shorter route, since it can consider
-            // routes that leave and reenter the current level.
-            if (player_level == target.id && stair == you.pos())
-                best_stair = target.pos;
+        // Already reached by a better route.
+        if (best[node.pos] < node.key())
+            continue;
 
-            // The local_distance is already set, but there may actually be
-            // stairs we can take that'll get us to the target faster than the
-            // direct route, so we also try the stairs.
-        }
-    }
+        const level_id &lev = node.pos.id;
+        const coord_def &pos = node.pos.pos;
+        LevelInfo &li = travel_cache.get_level_info(lev);
 
-    vector<stair_info> &stairs = li.get_stairs();
+        // Have we reached the target level?
+        if (lev == target.id)
+        {
+            // Are we in an exclude? If so, bail out. Unless it is just a
+            // stair exclusion.
+            if (is_excluded(pos, li.get_excludes()) && !is_stair_exclusion(pos))
+                continue;
 
-    // this_stair being nullptr is perfectly acceptable, since we start with
-    // coords as the player coords, and the player need not be standing on
-    // stairs.
-    stair_info *this_stair = li.get_stair(stair);
+            // If there's no target position on the target level, or we're on
+            // the target, we're home.
+            if (target.pos.x == -1 || target.pos == pos)
+            {
+                reach(target, node.distance, node.first_stair, true);
+                continue;
+            }
 
-    if (!this_stair && cur != player_level)
-    {
-        // Whoops, there's no stair in the travel cache for the current
-        // position, and we're not on the player's current level (i.e., there
-        // certainly *should* be a stair here). Since we can't proceed in any
-        // reasonable way, bail out.
-        return local_distance;
-    }
+            // If there *is* a target position, we need to work out our
+            // distance from it.
+            int deltadist = _target_distance_from(pos);
 
-    for (stair_info &si : stairs)
-    {
-        if (stairs_destination_is_excluded(si))
-            continue;
+            if (deltadist == -1 && lev == player_level)
+            {
+                // Okay, we don't seem to have a distance available to us,
+                // which means we're either (a) not standing on stairs or (b)
+                // whoever initiated interlevel travel didn't call
+                // _populate_stair_distances. Assuming we're not on stairs,
+                // that situation can arise only if interlevel travel has been
+                // triggered for a location on the same level. If that's the
+                // case, we can get the distance off the travel_point_distance
+                // matrix.
+                deltadist = travel_point_distance[target.pos.x][target.pos.y];
+                if (!deltadist && pos != target.pos)
+                    deltadist = -1;
+            }
 
-        // Skip placeholders and excluded stairs.
-        if (!si.can_travel() || is_excluded(si.position, li.get_excludes()))
-            continue;
+            // If we can walk to the target from the player's position, this
+            // is a degenerate case of interlevel travel, which decays to
+            // normal travel. There may still be stairs we can take that get
+            // us there faster, though, so we also try the stairs.
+            if (deltadist != -1)
+            {
+                reach(target, node.distance + deltadist,
+                      node.first_stair == TRANSTRAVEL_START
+                          ? TRANSTRAVEL_DIRECT : node.first_stair,
+                      true);
+            }
+        }
 
-        int deltadist = li.distance_between(this_stair, &si);
+        // this_stair being nullptr is perfectly acceptable, since we start
+        // with coords as the player coords, and the player need not be
+        // standing on stairs.
+        stair_info *this_stair = li.get_stair(pos);
 
-        if (!this_stair)
+        if (!this_stair && lev != player_level)
         {
-            deltadist = travel_point_distance[si.position.x][si.position.y];
-            if (!deltadist && you.pos() != si.position)
-                deltadist = -1;
-        }
-        // deltadist == 0 is legal (if this_stair is nullptr), since the player
-        // may be standing on the stairs. If two stairs are disconnected,
-        // deltadist has to be negative.
-        if (deltadist < 0)
+            // Whoops, there's no stair in the travel cache for the current
+            // position, and we're not on the player's current level (i.e.,
+            // there certainly *should* be a stair here). Since we can't
+            // proceed in any reasonable way, give up on this route.
             continue;
+        }
 
-        int dist2stair = distance + deltadist;
-        if (si.distance == -1 || si.distance > dist2stair)
+        const vector<stair_info> &stairs = li.get_stairs();
+        for (int i = 0, size = stairs.size(); i < size; ++i)
         {
-            si.distance = dist2stair;
+            const stair_info &si = stairs[i];
 
-            // Account for the cost of taking the stairs
-            dist2stair += 500; // XXX: this seems large?
+            // Don't go straight back the way we came.
+            if (&si == this_stair && node.first_stair != TRANSTRAVEL_START)
+                continue;
 
-            // Already too expensive? Short-circuit.
-            if (local_distance != -1 && dist2stair >= local_distance)
+            if (stairs_destination_is_excluded(si))
+                continue;
+
+            // Skip placeholders and excluded stairs.
+            if (!si.can_travel() || is_excluded(si.position, li.get_excludes()))
+                continue;
+
+            int deltadist = li.distance_between(this_stair, &si);
+
+            if (!this_stair)
+            {
+                deltadist = travel_point_distance[si.position.x][si.position.y];
+                if (!deltadist && you.pos() != si.position)
+                    deltadist = -1;
+            }
+            // deltadist == 0 is legal (if this_stair is nullptr), since the
+            // player may be standing on the stairs. If two stairs are
+            // disconnected, deltadist has to be negative.
+            if (deltadist < 0)
                 continue;
 
+            const int first_stair = node.first_stair == TRANSTRAVEL_START
+                                    ? i : node.first_stair;
+
+            // Account for the cost of taking the stairs
+            const int dist2stair = node.distance + deltadist
+                                   + 500; // XXX: this seems large?
+
             const level_pos &dest = si.destination;
 
             // Never use escape hatches as the last leg of the trip, since
@@ -2789,19 +3102,13 @@ static int _find_transtravel_stair(const level_id &cur,
                 continue;
             }
 
-            // We can only short-circuit the stair-following process if we
-            // have no exact target location. If there *is* an exact target
-            // location, we can't follow stairs for which we have incomplete
-            // information.
+            // We can only stop at the stairs if we have no exact target
+            // location. If there *is* an exact target location, we can't
+            // follow stairs for which we have incomplete information.
             if (target.pos.x == -1
                 && dest.id == target.id)
             {
-                if (local_distance == -1 || local_distance > dist2stair)
-                {
-                    local_distance = dist2stair;
-                    if (cur == player_level && you.pos() == stair)
-                        best_stair = si.position;
-                }
+                reach(target, dist2stair, first_stair, true);
                 continue;
             }
 
@@ -2830,51 +3137,70 @@ static int _find_transtravel_stair(const level_id &cur,
             // used while exiting from the vestibule.
             if (is_hell_branch(dest.id.branch)
                             && !(is_hell_branch(target.id.branch)
-                                 || is_hell_branch(cur.branch)))
+                                 || is_hell_branch(lev.branch)))
             {
                 continue;
             }
 
-            // We need to get the stairs at the new location and set the
-            // distance on them as well.
-            LevelInfo &lo = travel_cache.get_level_info(dest.id);
-            if (stair_info *so = lo.get_stair(dest.pos))
-            {
-                if (so->distance == -1 || so->distance > dist2stair)
-                    so->distance = dist2stair;
-                else
-                    continue;   // We've already been here.
-            }
 #ifdef DEBUG_TRAVEL
-            string indent(search_depth, '.');
-            dprf("%strying stairs at %d,%d, dest is %d depth %d, pos %d,%d",
-                indent.c_str(), si.position.x, si.position.y, dest.id.branch,
+            dprf("trying stairs at %d,%d, dest is %d depth %d, pos %d,%d",
+                si.position.x, si.position.y, dest.id.branch,
                 dest.id.depth, dest.pos.x, dest.pos.y);
 #endif
 
             // Okay, take these stairs and keep going.
-            const int newdist =
-                _find_transtravel_stair(dest.id, target,
-                                        dist2stair, dest.pos, closest_level,
-                                        best_level_distance, best_stair,
-                                        search_depth + 1);
-            if (newdist != -1
-                && (local_distance == -1 || local_distance > newdist))
-            {
-                local_distance = newdist;
-                if (cur == player_level && you.pos() == stair)
-                    best_stair = si.position;
-            }
+            reach(dest, dist2stair, first_stair, false);
         }
     }
-    return local_distance;
+    return -1;
+}
+
+// Distances from the targets of interlevel travel on other levels to the
+// stairs on their levels. Working them out means loading the level, so they
+// are kept until the player next enters it or its stairs change.
+static map<level_pos, vector<stair_info>> _target_stair_distances;
+
+static bool _same_stair_positions(const vector<stair_info> &a,
+                                  const vector<stair_info> &b)
+{
+    if (a.size() != b.size())
+        return false;
+
+    for (int i = 0, size = a.size(); i < size; ++i)
+        if (a[i].position != b[i].position)
+            return false;
+
+    return true;
+}
+
+static void _forget_target_stair_distances(const level_id &lev)
+{
+    for (auto it = _target_stair_distances.begin();
+         it != _target_stair_distances.end();)
+    {
+        if (it->first.id == lev)
+            it = _target_stair_distances.erase(it);
+        else
+            ++it;
+    }
 }
 
 static bool _loadlev_populate_stair_distances(const level_pos &target)
 {
+    const vector<stair_info> *cached = map_find(_target_stair_distances,
+                                                target);
+    if (cached
+        && _same_stair_positions(*cached,
+               travel_cache.get_level_info(target.id).get_stairs()))
+    {
+        curr_stairs = *cached;
+        return true;
+    }
+
     level_excursion excursion;
     excursion.go_to(target.id);
     _populate_stair_distances(target);
+    _target_stair_distances[target] = curr_stairs;
     return true;
 }
 
@@ -2906,7 +3232,6 @@ static bool _find_transtravel_square(const level_pos &target, bool verbose)
 
     level_id closest_level;
     int best_level_distance = -1;
-    travel_cache.clear_distances();
 
     find_travel_pos(you.pos(), nullptr, nullptr, nullptr);
 
@@ -2919,8 +3244,7 @@ static bool _find_transtravel_square(const level_pos &target, bool verbose)
 
     if (maybe_traversable)
     {
-        _find_transtravel_stair(current, target,
-                                0, cur_stair, closest_level,
+        _find_transtravel_stair(current, target, cur_stair, closest_level,
                                 best_level_distance, best_stair);
         dprf("found stair at %d,%d", best_stair.x, best_stair.y);
     }
@@ -3026,6 +3350,49 @@ void start_travel(const coord_def& p)
         start_translevel_travel(level_target);
 }
 
+/**
+ * Work out where explore would go from here, so that an explore command
+ * issued before anything else happens need not. This is meant to be called
+ * while the game waits for a command, once the screen is up to date.
+ */
+void precompute_explore_target()
+{
+    forget_explore_target();
+
+    if (you.running || you.confused() || you.berserk())
+        return;
+
+    const run_mode_type rmode = Options.explore_greedy ? RMODE_EXPLORE_GREEDY
+                                                       : RMODE_EXPLORE;
+
+    // The flood may set an explore target of its own.
+    unwind_var<coord_def> running_pos(you.running.pos);
+
+    travel_pathfind tp;
+    bool runed_door_pause;
+    const coord_def whereto = _explore_target(rmode, tp, runed_door_pause);
+    if (whereto.origin())
+        return;
+
+    precomputed_explore_target &pre = _precomputed_explore;
+    pre.valid = true;
+    pre.level = level_id::current();
+    pre.pos = you.pos();
+    pre.turn = you.num_turns;
+    pre.mode = rmode;
+    pre.target = whereto;
+
+    // Flood towards the target too, for the first move.
+    if (whereto != you.pos())
+    {
+        travel_pathfind move_tp;
+        move_tp.set_src_dst(you.pos(), whereto);
+        _travel_flood_cache.start(whereto);
+        move_tp.set_flood_cache(&_travel_flood_cache);
+        move_tp.pathfind(RMODE_TRAVEL);
+    }
+}
+
 void start_explore(bool grab_items)
 {
     if (Hints.hints_explored)
@@ -3643,12 +4010,6 @@ void LevelInfo::get_stairs(vector<coord_def> &st)
     }
 }
 
-void LevelInfo::clear_distances()
-{
-    for (stair_info &stair : stairs)
-        stair.clear_distance();
-}
-
 bool LevelInfo::is_known_branch(uint8_t branch) const
 {
     for (const stair_info &stair : stairs)
@@ -4007,12 +4368,6 @@ int TravelCache::get_waypoint_count() const
     return count;
 }
 
-void TravelCache::clear_distances()
-{
-    for (auto &entry : levels)
-        entry.second.clear_distances();
-}
-
 bool TravelCache::is_known_branch(uint8_t branch) const
 {
     return any_of(begin(levels), end(levels),
@@ -84,6 +84,11 @@ bool is_stair_exclusion(const coord_def &p);
 void start_explore(bool grab_items = false);
 void do_explore_cmd();
 
+// Work out explore's next target ahead of an explore command, or forget one
+// that was worked out earlier.
+void precompute_explore_target();
+void forget_explore_target();
+
 struct level_pos;
 class level_id;
 
@@ -278,8 +283,6 @@ public:
     {
     }
 
-    void clear_distance() { distance = -1; }
-
     void save(writer&) const;
     void load(reader&);
 
@@ -345,7 +348,6 @@ struct LevelInfo
     int get_stair_index(const coord_def &pos) const;
     int get_transporter_index(const coord_def &pos) const;
 
-    void clear_distances();
     void set_level_excludes();
 
     const exclude_set &get_excludes() const
@@ -411,8 +413,6 @@ const int TRAVEL_WAYPOINT_COUNT = 10;
 class TravelCache
 {
 public:
-    void clear_distances();
-
     LevelInfo& get_level_info(const level_id &lev)
     {
         LevelInfo &li = levels[lev];
@@ -478,6 +478,8 @@ private:
     level_pos waypoints[TRAVEL_WAYPOINT_COUNT];
 };
 
+class travel_flood_cache;
+
 // Handles travel and explore floodfill pathfinding. Does not do interlevel
 // travel pathfinding directly (but is used internally by interlevel travel).
 // * All coordinates are grid coords.
@@ -510,6 +512,10 @@ public:
     // Set feature vector to use; if non-nullptr, also sets annotate_map to true.
     void set_feature_vector(vector<coord_def> *features);
 
+    // Record the squares examined by a travel flood, so that later moves
+    // towards the same destination can reuse it.
+    void set_flood_cache(travel_flood_cache *cache);
+
     // Extract features without pathfinding
     void get_features();
 
@@ -601,6 +607,8 @@ protected:
 
     vector<coord_def> *features;
 
+    travel_flood_cache *flood_cache;
+
     // List of unexplored and unreachable points.
     set<coord_def> unreachables;
 
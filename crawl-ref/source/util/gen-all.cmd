@@ -16,6 +16,8 @@ perl util/cmd-name.pl
 perl util/gen-luatags.pl
 :: mi-enum.h
 perl util/gen-mi-enum
+:: los-rays.h
+python util/gen-los-rays.py defines.h los-rays.h
 :: docs/aptitudes.txt
 perl util/gen-apt.pl ../docs/aptitudes.txt ../docs/template/apt-tmpl.txt species-data.h aptitudes.h
 :: docs/aptitudes-wide.txt
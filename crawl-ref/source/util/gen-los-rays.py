@@ -0,0 +1,412 @@
+#!/usr/bin/env python
+
+"""
+Precompute the LOS ray tables used by los.cc.
+
+This mirrors raycast() and _find_minimal_cellrays() in los.cc, together
+with the parts of ray.cc and geom2d.cc needed to find the footprint of a
+ray, and writes the result as static arrays. los.cc checks the parameters
+and checksum of the tables on startup and falls back to computing them
+itself if they don't match.
+
+The floating point operations are done in the same order as in the C++
+code, so that rays that just touch a corner are treated the same.
+
+Usage: gen-los-rays.py defines.h los-rays.h
+"""
+
+from __future__ import division, print_function
+
+import math
+import re
+import sys
+
+# These have to match los.cc.
+LOS_INTERCEPT_MULT = 2
+
+
+def los_max_angle(los_max_range):
+    return 2 * los_max_range - 2
+
+
+def c_round(d):
+    """round() from C: halfway cases are rounded away from zero."""
+    r = math.floor(abs(d))
+    if abs(d) - r >= 0.5:
+        r += 1
+    return math.copysign(r, d)
+
+
+# geom2d.cc
+
+def geom_is_zero(d):
+    return abs(d) < 0.0000001
+
+
+class LineSeq(object):
+    def __init__(self, a, b, offset, dist):
+        self.a = a
+        self.b = b
+        self.offset = offset
+        self.dist = dist
+
+    def f(self, x, y):
+        return self.a * x + self.b * y
+
+    def index(self, x, y):
+        return (self.f(x, y) - self.offset) / self.dist
+
+
+DIAMONDS = (LineSeq(1.0, 1.0, 0.5, 1.0), LineSeq(1.0, -1.0, -0.5, 1.0))
+
+
+class Ray(object):
+    def __init__(self, x, y, dx, dy):
+        self.x = x
+        self.y = y
+        self.dx = dx
+        self.dy = dy
+        self.on_corner = False
+
+    def copy(self):
+        r = Ray(self.x, self.y, self.dx, self.dy)
+        r.on_corner = self.on_corner
+        return r
+
+    def advance_by(self, t):
+        self.x = self.x + t * self.dx
+        self.y = self.y + t * self.dy
+
+    def nextintersect(self, ls):
+        fp = ls.f(self.x, self.y)
+        fd = ls.f(self.dx, self.dy)
+        a = (fp - ls.offset) / ls.dist
+        k = math.ceil(a) if ls.dist * fd > 0 else math.floor(a)
+        if geom_is_zero(k - a):
+            k += 1 if ls.dist * fd > 0 else -1
+        return (k - a) * ls.dist / fd
+
+    def geom_to_grid(self, half):
+        ls1, ls2 = DIAMONDS
+        corner = False
+        if geom_is_zero(ls1.f(self.dx, self.dy)):
+            t = self.nextintersect(ls2)
+        elif geom_is_zero(ls2.f(self.dx, self.dy)):
+            t = self.nextintersect(ls1)
+        else:
+            r = self.nextintersect(ls1)
+            s = self.nextintersect(ls2)
+            t = s if s < r else r
+            corner = geom_is_zero(r - s)
+        self.advance_by(0.5 * t if half else t)
+        return corner and not half
+
+    def geom_to_next_cell(self):
+        if self.geom_to_grid(False):
+            return True
+        self.geom_to_grid(True)
+        return False
+
+
+# ray.cc; this uses double_is_zero() from los.cc.
+
+def is_zero(d):
+    return -0.00001 < d < 0.00001
+
+
+def is_integral(d):
+    return is_zero(d - c_round(d))
+
+
+def ifloor(d):
+    r = int(c_round(d))
+    if is_zero(d - r):
+        return r
+    return int(math.floor(d))
+
+
+def is_corner(x, y):
+    return (is_integral(DIAMONDS[0].index(x, y))
+            and is_integral(DIAMONDS[1].index(x, y)))
+
+
+def round_to_corner(r):
+    r.x = 0.5 * c_round(2.0 * r.x)
+    r.y = 0.5 * c_round(2.0 * r.y)
+
+
+def round_to_grid(r):
+    s = r.x + r.y - 0.5
+    d = r.x - r.y - 0.5
+    deltas = c_round(s) - s
+    deltad = c_round(d) - d
+    if abs(deltas) <= abs(deltad):
+        r.x += 0.5 * deltas
+        r.y += 0.5 * deltas
+    else:
+        r.x += 0.5 * deltad
+        r.y -= 0.5 * deltad
+
+
+def to_next_cell(r):
+    c = r.geom_to_next_cell()
+    if c:
+        round_to_corner(r)
+    return c
+
+
+def to_grid(r, half):
+    c = r.geom_to_grid(half)
+    if not half:
+        round_to_grid(r)
+    c = c or is_corner(r.x, r.y)
+    if c:
+        round_to_corner(r)
+    return c
+
+
+def advance(r):
+    """ray_def::advance(), without the assertions."""
+    n = math.sqrt(r.dx * r.dx + r.dy * r.dy)
+    t = 1.0 / n
+    r.dx = t * r.dx
+    r.dy = t * r.dy
+    if r.on_corner:
+        r.on_corner = False
+        to_grid(r, True)
+    elif to_next_cell(r):
+        to_grid(r, True)
+        return True
+
+    r.on_corner = to_next_cell(r)
+    return not r.on_corner
+
+
+def pos(r):
+    return (ifloor(r.x), ifloor(r.y))
+
+
+# los.cc
+
+class FullRay(object):
+    def __init__(self, params, coords):
+        # params: xnum, xden, ynum, yden, xdir, ydir
+        self.params = params
+        self.coords = coords
+        self.start = 0
+
+    def geom(self):
+        xnum, xden, ynum, yden, xdir, ydir = self.params
+        return Ray(float(xnum) / xden, float(ynum) / yden,
+                   float(xdir), float(ydir))
+
+
+def footprint(ray, los_radius):
+    cs = []
+    copy = ray.copy()
+    while True:
+        if not advance(copy):
+            return []
+        c = pos(copy)
+        if max(abs(c[0]), abs(c[1])) > los_radius:
+            return cs
+        cs.append(c)
+
+
+def gcd(x, y):
+    while y != 0:
+        x, y = y, x % y
+    return x
+
+
+def cast_rays(los_radius):
+    fullrays = []
+    seen = set()
+
+    def register(params):
+        ray = FullRay(params, [])
+        coords = footprint(ray.geom(), los_radius)
+        if not coords or tuple(coords) in seen:
+            return
+        seen.add(tuple(coords))
+        ray.coords = coords
+        fullrays.append(ray)
+
+    register((1, 2, 1, 2, 0, 1))
+    register((1, 2, 1, 2, 1, 0))
+
+    max_angle = los_max_angle(los_radius)
+    xyangles = [(x, y) for x in range(1, max_angle + 1)
+                       for y in range(1, max_angle + 1)
+                       if gcd(x, y) == 1]
+    # Stable, like std::stable_sort in los.cc.
+    xyangles.sort(key=lambda xy: xy[0] * xy[1])
+    for xangle, yangle in xyangles:
+        den = LOS_INTERCEPT_MULT * yangle
+        for intercept in range(1, den):
+            register((intercept, den, 1, 2, xangle, yangle))
+            register((1, 2, intercept, den, yangle, xangle))
+
+    start = 0
+    for ray in fullrays:
+        ray.start = start
+        start += len(ray.coords)
+    return fullrays
+
+
+class CellRay(object):
+    def __init__(self, ray, end):
+        self.ray = ray
+        self.end = end
+
+    def target(self):
+        return self.ray.coords[self.end]
+
+    def calc_params(self):
+        self.imbalance = imbalance(self.ray.geom(), self.target())
+        c = self.ray.coords[0]
+        self.first_diag = c[0] * c[0] + c[1] * c[1] == 2
+
+
+def imbalance(ray, target):
+    imb = 0
+    diags = 0
+    straights = 0
+    p = pos(ray)
+    while p != target:
+        old = p
+        advance(ray)
+        p = pos(ray)
+        if abs(p[0] - old[0]) + abs(p[1] - old[1]) == 1:
+            diags = 0
+            straights += 1
+            imb = max(imb, straights)
+        else:
+            straights = 0
+            diags += 1
+            imb = max(imb, diags)
+    return imb
+
+
+SUBRAY, SUPERRAY, NEITHER = range(3)
+
+
+def compare_cellrays(a, b):
+    if a.target() != b.target():
+        return NEITHER
+
+    cura = 0
+    curb = 0
+    maybe_sub = True
+    maybe_super = True
+
+    while cura < a.end and curb < b.end and (maybe_sub or maybe_super):
+        pa = a.ray.coords[cura]
+        pb = b.ray.coords[curb]
+        if pa[0] > pb[0] or pa[1] > pb[1]:
+            maybe_super = False
+            curb += 1
+        if pa[0] < pb[0] or pa[1] < pb[1]:
+            maybe_sub = False
+            cura += 1
+        if pa == pb:
+            cura += 1
+            curb += 1
+
+    if maybe_sub and cura == a.end:
+        return SUBRAY
+    if maybe_super and curb == b.end:
+        return SUPERRAY
+    return NEITHER
+
+
+def find_minimal_cellrays(fullrays):
+    minima = {}
+    for ray in fullrays:
+        for i in range(len(ray.coords)):
+            c = CellRay(ray, i)
+            mins = minima.setdefault(c.target(), [])
+            dup = False
+            j = 0
+            while j < len(mins) and not dup:
+                cmp = compare_cellrays(mins[j], c)
+                if cmp == SUBRAY:
+                    dup = True
+                elif cmp == SUPERRAY:
+                    del mins[j]
+                    continue
+                j += 1
+            if not dup:
+                mins.append(c)
+
+    for mins in minima.values():
+        for c in mins:
+            c.calc_params()
+        # Stable, like list::sort in los.cc.
+        mins.sort(key=lambda c: (c.imbalance, not c.first_diag))
+    return minima
+
+
+def checksum(values):
+    """32-bit FNV-1a over the table entries; see _ray_table_checksum()."""
+    h = 2166136261
+    for v in values:
+        h = ((h ^ (v & 0xffffffff)) * 16777619) & 0xffffffff
+    return h
+
+
+def write_table(out, name, comment, rows):
+    out.write("// %s\n" % comment)
+    out.write("static const int %s[][%d] =\n{\n" % (name, len(rows[0])))
+    for row in rows:
+        out.write("    { %s },\n" % ", ".join(str(v) for v in row))
+    out.write("};\n\n")
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit("Usage: %s defines.h los-rays.h" % sys.argv[0])
+
+    with open(sys.argv[1]) as f:
+        m = re.search(r"^#define LOS_RADIUS (\d+)", f.read(), re.M)
+    if not m:
+        sys.exit("Couldn't find LOS_RADIUS in %s" % sys.argv[1])
+    los_radius = int(m.group(1))
+
+    fullrays = cast_rays(los_radius)
+    minima = find_minimal_cellrays(fullrays)
+    ray_index = dict((id(r), i) for i, r in enumerate(fullrays))
+
+    fullray_rows = [list(r.params) + [r.start, len(r.coords)]
+                    for r in fullrays]
+    coord_rows = [list(c) for r in fullrays for c in r.coords]
+    cellray_rows = []
+    # In quadrant_iterator order.
+    for y in range(los_radius + 1):
+        for x in range(los_radius + 1):
+            for c in minima.get((x, y), []):
+                cellray_rows.append([ray_index[id(c.ray)], c.end,
+                                     c.imbalance, int(c.first_diag)])
+
+    values = [v for rows in (fullray_rows, coord_rows, cellray_rows)
+                for row in rows for v in row]
+
+    with open(sys.argv[2], "w") as out:
+        out.write("// Generated by util/gen-los-rays.py; do not edit.\n\n")
+        out.write("#pragma once\n\n")
+        out.write("#define LOS_RAYS_RADIUS %d\n" % los_radius)
+        out.write("#define LOS_RAYS_MAX_ANGLE %d\n"
+                  % los_max_angle(los_radius))
+        out.write("#define LOS_RAYS_INTERCEPT_MULT %d\n" % LOS_INTERCEPT_MULT)
+        out.write("#define LOS_RAYS_CHECKSUM 0x%08xU\n\n" % checksum(values))
+        write_table(out, "los_fullray_data",
+                    "xnum, xden, ynum, yden, xdir, ydir, start, length",
+                    fullray_rows)
+        write_table(out, "los_ray_coord_data", "x, y", coord_rows)
+        write_table(out, "los_cellray_data",
+                    "fullray, end, imbalance, first_diag; grouped by target",
+                    cellray_rows)
+
+
+if __name__ == "__main__":
+    main()
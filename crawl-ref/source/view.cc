@@ -603,6 +603,9 @@ bool magic_mapping(int map_radius, int proportion, bool suppress_msg,
     const FixedArray<uint8_t, GXM, GYM>& difficulty =
         _tile_difficulties(!deterministic);
 
+    // Exclusions look through the map knowledge changed here.
+    vector<coord_def> excludes;
+
     for (radius_iterator ri(in_bounds(origin) ? origin : you.pos(),
                             map_radius, C_SQUARE);
          ri; ++ri)
@@ -638,6 +641,7 @@ bool magic_mapping(int map_radius, int proportion, bool suppress_msg,
             }
             else
                 knowledge.clear();
+            excludes.push_back(pos);
         }
 
         // Don't assume that DNGN_UNSEEN cells ever count as mapped.
@@ -704,10 +708,13 @@ bool magic_mapping(int map_radius, int proportion, bool suppress_msg,
                     num_shops_portals++;
             }
 
+            excludes.push_back(pos);
             did_map = true;
         }
     }
 
+    update_exclusion_los(excludes);
+
     if (!suppress_msg)
     {
         if (did_map)
@@ -739,6 +746,7 @@ bool magic_mapping(int map_radius, int proportion, bool suppress_msg,
 
 void fully_map_level()
 {
+    vector<coord_def> excludes;
     for (rectangle_iterator ri(1); ri; ++ri)
     {
         bool ok = false;
@@ -747,6 +755,7 @@ void fully_map_level()
                 ok = true;
         if (!ok)
             continue;
+        excludes.push_back(*ri);
         env.map_knowledge(*ri).set_feature(grd(*ri), 0,
             feat_is_trap(grd(*ri)) ? get_trap_type(*ri) : TRAP_UNASSIGNED);
         set_terrain_seen(*ri);
@@ -757,6 +766,7 @@ void fully_map_level()
             env.map_knowledge(*ri).set_detected_item();
         env.pgrid(*ri) |= FPROP_SEEN_OR_NOEXP;
     }
+    update_exclusion_los(excludes);
 }
 
 bool mon_enemies_around(const monster* mons)
@@ -49,6 +49,11 @@ template_path = "./webserver/templates/"
 # Path for server-side unix sockets (to be used to communicate with crawl)
 server_socket_path = None # Uses global temp dir
 
+# Pass large messages from crawl through a shared memory ring buffer file
+# next to the server-side socket, instead of many socket datagrams. Only
+# works with crawl versions that support it; older ones ignore the setting.
+#shared_memory_ring_size = 4 * 1024 * 1024
+
 # Server name, so far only used in the ttyrec metadata
 server_id = ""
 
@@ -1,14 +1,25 @@
 import socket
 import fcntl
+import mmap
 import os, os.path
+import struct
 import time
 import warnings
 
 from datetime import datetime, timedelta
 from tornado.escape import json_encode
 
+import config
 from config import server_socket_path
 
+# Must match ring_header in tileweb.cc
+RING_MAGIC = "DCRB"
+RING_DATA_OFFSET = 64
+RING_WRITE_POS = 8
+RING_READ_POS = 16
+# ring_record: position and length of the message that follows
+RING_RECORD = struct.Struct("=QQ")
+
 class WebtilesSocketConnection(object):
     def __init__(self, io_loop, socketpath, logger):
         self.io_loop = io_loop
@@ -21,6 +32,9 @@ class WebtilesSocketConnection(object):
         self.close_callback = None
 
         self.msg_buffer = None
+        self.ring = None
+        self.ring_path = None
+        self.ring_size = 0
 
     def connect(self, primary = True):
         if not os.path.exists(self.crawl_socketpath):
@@ -59,15 +73,81 @@ class WebtilesSocketConnection(object):
                                  self._handle_read,
                                  self.io_loop.ERROR | self.io_loop.READ)
 
-        msg = json_encode({
-                "msg": "attach",
-                "primary": primary
-                })
+        attach = {
+            "msg": "attach",
+            "primary": primary
+            }
+        ring_size = getattr(config, "shared_memory_ring_size", None)
+        if ring_size:
+            self._create_ring(ring_size)
+            attach["ring"] = self.ring_path
+
+        msg = json_encode(attach)
 
         self.open = True
 
         self.send_message(msg)
 
+    def _create_ring(self, size):
+        self.ring_path = self.socketpath + ".ring"
+        fd = os.open(self.ring_path, os.O_RDWR | os.O_CREAT | os.O_TRUNC,
+                     0600)
+        try:
+            os.ftruncate(fd, RING_DATA_OFFSET + size)
+            self.ring = mmap.mmap(fd, RING_DATA_OFFSET + size)
+        finally:
+            os.close(fd)
+        self.ring_size = size
+        struct.pack_into("=4sIQQ", self.ring, 0, RING_MAGIC, size, 0, 0)
+
+    def _ring_bytes(self, pos, length):
+        start = RING_DATA_OFFSET + pos % self.ring_size
+        first = min(length, RING_DATA_OFFSET + self.ring_size - start)
+        data = self.ring[start:start + first]
+        if first < length:
+            data += self.ring[RING_DATA_OFFSET:
+                              RING_DATA_OFFSET + length - first]
+        return data
+
+    def _read_ring(self, notice):
+        # The crawl process sends "@<pos> <length>" after writing a message
+        # of that length into the ring buffer at pos, or just "@<pos>" when
+        # everything before pos may be forgotten. Returns the message, or
+        # None if there isn't one.
+        try:
+            fields = [int(f) for f in notice[1:].split()]
+        except ValueError:
+            fields = []
+        if len(fields) not in (1, 2):
+            self.logger.warning("Bad ring buffer notice: %r", notice)
+            return None
+
+        pos = fields[0]
+        read_pos, = struct.unpack_from("=Q", self.ring, RING_READ_POS)
+        write_pos, = struct.unpack_from("=Q", self.ring, RING_WRITE_POS)
+        if len(fields) == 1:
+            if read_pos <= pos <= write_pos:
+                struct.pack_into("=Q", self.ring, RING_READ_POS, pos)
+            return None
+
+        length = fields[1]
+        end = pos + RING_RECORD.size + length
+        data = None
+        if read_pos <= pos and end <= write_pos:
+            record = RING_RECORD.unpack(self._ring_bytes(pos,
+                                                         RING_RECORD.size))
+            data = self._ring_bytes(pos + RING_RECORD.size, length)
+            if record != (pos, length) or not data.endswith("\n"):
+                data = None
+        if data is None:
+            self.logger.warning("Ring buffer out of sync, dropping message "
+                                "(notice %r, read %d, write %d)", notice,
+                                read_pos, write_pos)
+            return None
+
+        struct.pack_into("=Q", self.ring, RING_READ_POS, end)
+        return data
+
     def _handle_read(self, fd, events):
         if events & self.io_loop.READ:
             data = self.socket.recv(128 * 1024, socket.MSG_DONTWAIT)
@@ -78,6 +158,11 @@ class WebtilesSocketConnection(object):
             pass
 
     def _handle_data(self, data):
+        if self.ring and self.msg_buffer is None and data.startswith("@"):
+            data = self._read_ring(data.strip())
+            if data is None:
+                return
+
         if self.msg_buffer is not None:
             data = self.msg_buffer + data
 
@@ -110,5 +195,9 @@ class WebtilesSocketConnection(object):
             self.socket.close()
             os.remove(self.socketpath)
             self.socket = None
+        if self.ring:
+            self.ring.close()
+            os.remove(self.ring_path)
+            self.ring = None
         if self.close_callback:
             self.close_callback()
@@ -0,0 +1,62 @@
+import zlib
+
+def new_compressobj():
+    return zlib.compressobj(zlib.Z_DEFAULT_COMPRESSION, zlib.DEFLATED,
+                            -zlib.MAX_WBITS)
+
+class DeflateGroup(object):
+    """A compression context shared by the sockets watching one game, so
+    that a message sent to all of them is only compressed once.
+
+    A socket is in sync while its client has received exactly the group's
+    frames since it joined; it can then be sent the next frame, or start it.
+    A socket that misses a frame drops out. The first socket that is out of
+    sync and has a message the group hasn't compressed starts a resync
+    frame, which is compressed after a full flush and so doesn't refer to
+    anything sent before it. Every other socket with the same message takes
+    that frame and is back in sync, whatever order the sockets are sent
+    to."""
+    def __init__(self):
+        self._compressobj = new_compressobj()
+        self.members = set()
+        self.seq = 0
+        self.last_msg = None
+        self.last_frame = None
+        self.last_resync = False
+
+    def add(self, socket):
+        self.members.add(socket)
+        socket.deflate_group = self
+        socket.deflate_seq = None
+
+    def remove(self, socket):
+        self.members.discard(socket)
+        socket.deflate_group = None
+        socket.deflate_seq = None
+
+    def _new_frame(self, socket, msg, resync):
+        prefix = b""
+        if resync:
+            prefix = self._compressobj.flush(zlib.Z_FULL_FLUSH)
+        frame = prefix + self._compressobj.compress(msg)
+        frame += self._compressobj.flush(zlib.Z_SYNC_FLUSH)
+        self.seq += 1
+        self.last_msg = msg
+        self.last_frame = frame[:-4]
+        self.last_resync = resync
+        socket.deflate_seq = self.seq
+        return self.last_frame
+
+    def compress(self, socket, msg):
+        """Returns the frame to send to the socket."""
+        if socket.deflate_seq == self.seq:
+            return self._new_frame(socket, msg, False)
+
+        if (msg == self.last_msg and
+            (socket.deflate_seq == self.seq - 1 or self.last_resync)):
+            socket.deflate_seq = self.seq
+            return self.last_frame
+
+        # The socket is out of sync: sockets that are still in sync can take
+        # a resync frame too, so start one for everybody.
+        return self._new_frame(socket, msg, True)
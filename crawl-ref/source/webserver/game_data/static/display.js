@@ -91,6 +91,8 @@ function ($, comm, map_knowledge, view_data, monster_list, minimap,
 
         if (data.cells)
             map_knowledge.merge(data.cells);
+        else if (data.cz)
+            map_knowledge.merge_compact(data.cz);
 
         // Mark cells overlapped by dirty cells as dirty
         $.each(map_knowledge.dirty().slice(), function (i, loc) {
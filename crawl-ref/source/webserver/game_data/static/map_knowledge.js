@@ -207,9 +207,74 @@ define(["jquery", "./enums", "./util"], function ($, enums, util) {
         clean_monster_table();
     };
 
+    // Field names of the compact map encoding, in the order of their bits;
+    // see TilesFramework::_send_map. Fields from "fg" onwards belong to the
+    // tile data.
+    var compact_fields = [
+        "f", "mon", "mf", "g", "col",
+        "fg", "base", "bg", "cloud", "bloody", "old_blood", "silenced",
+        "halo", "moldy", "glowing_mold", "sanctuary", "liquefied", "orb_glow",
+        "quad_glow", "disjunct", "mangrove_water", "awakened_forest",
+        "blood_rotation", "travel_trail", "flv", "doll", "ov"
+    ];
+    var first_tile_field = 5;
+
+    function decode_compact_cell(data, x, y)
+    {
+        var bits = data[data.length - 1];
+        var val = {x: x, y: y};
+        var t = null;
+        var v = 0;
+        for (var i = 0; i < compact_fields.length; i++)
+        {
+            if (!(bits & (1 << i)))
+                continue;
+
+            var field = data[v++];
+            if (i < first_tile_field)
+            {
+                val[compact_fields[i]] = field;
+                continue;
+            }
+
+            t = t || {};
+            if (compact_fields[i] == "doll")
+            {
+                // The doll and mcache are sent as one object
+                for (var prop in field)
+                    t[prop] = field[prop];
+            }
+            else
+                t[compact_fields[i]] = field;
+        }
+        if (t)
+            val.t = t;
+        return val;
+    }
+
+    function merge_compact(vals)
+    {
+        var x = 0, y = 0;
+        for (var i = 0; i < vals.length; i++)
+        {
+            if (typeof vals[i] === "number")
+            {
+                x = vals[i];
+                y = vals[++i];
+                continue;
+            }
+
+            merge(decode_compact_cell(vals[i], x, y));
+            x++;
+        }
+
+        clean_monster_table();
+    }
+
     return {
         get: get,
         merge: merge_diff,
+        merge_compact: merge_compact,
         clear: clear,
         touch: touch,
         visible: visible,
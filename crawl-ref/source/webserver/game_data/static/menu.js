@@ -184,7 +184,8 @@ function ($, comm, client, ui, enums, cr, util, options, scroller) {
             var item = {
                 level: 2,
                 text: "...",
-                index: i
+                index: i,
+                placeholder: true
             };
             var elem = $("<li>...</li>");
             elem.data("item", item);
@@ -224,6 +225,8 @@ function ($, comm, client, ui, enums, cr, util, options, scroller) {
             $.extend(item, new_item);
             if (new_item.colour === undefined)
                 delete item.colour;
+            delete item.placeholder;
+            delete item.requested;
 
             set_item_contents(item, item.elem);
         }
@@ -352,6 +355,7 @@ function ($, comm, client, ui, enums, cr, util, options, scroller) {
             first: menu.first_visible,
             last: menu.last_visible
         });
+        request_missing_items();
     }
 
     function schedule_server_scroll()
@@ -453,8 +457,68 @@ function ($, comm, client, ui, enums, cr, util, options, scroller) {
         menu.elem.find(".menu_more").html(util.formatted_string_to_html(menu.more));
     }
 
+    function forget_items(keep_start, keep_end)
+    {
+        // Turn items outside the given range back into placeholders
+        for (var i = 0; i < menu.total_items; ++i)
+        {
+            var item = menu.items[i];
+            if (!item || item.placeholder || (i >= keep_start && i <= keep_end))
+                continue;
+
+            var placeholder = {
+                level: 2,
+                text: "...",
+                index: i,
+                placeholder: true,
+                elem: item.elem
+            };
+            item.elem.off("click.menu_item");
+            item.elem.removeClass();
+            item.elem.addClass("placeholder");
+            item.elem.html("...");
+            item.elem.data("item", placeholder);
+            menu.items[i] = placeholder;
+        }
+    }
+
+    // Large menus are only sent in part; ask for missing items near the
+    // visible ones.
+    var prefetch_margin = 50;
+    function request_missing_items()
+    {
+        if (!menu || menu.type === "crt" || client.is_watching())
+            return;
+
+        var start = Math.max(0, menu.first_visible - prefetch_margin);
+        var end = Math.min(menu.total_items - 1,
+                           Math.max(menu.first_visible, menu.last_visible)
+                           + prefetch_margin);
+        var first = null, last = null;
+        for (var i = start; i <= end; ++i)
+        {
+            var item = menu.items[i];
+            if (item && item.placeholder && !item.requested)
+            {
+                if (first === null)
+                    first = i;
+                last = i;
+                item.requested = true;
+            }
+        }
+
+        if (first !== null)
+            comm.send_message("*request_menu_range", {start: first, end: last});
+    }
+
     function update_menu_items(data)
     {
+        // A reset means items outside the chunk are out of date
+        if (data.reset)
+        {
+            forget_items(data.chunk_start,
+                         data.chunk_start + data.items.length - 1);
+        }
         update_item_range(data.chunk_start, data.items);
         handle_size_change();
     }
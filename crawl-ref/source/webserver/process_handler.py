@@ -15,6 +15,7 @@ from connection import WebtilesSocketConnection
 from util import DynamicTemplateLoader, dgl_format_str, parse_where_data
 from game_data_handler import GameDataHandler
 from ws_handler import update_all_lobbys, remove_in_lobbys
+from deflate import DeflateGroup
 from inotify import DirectoryWatcher
 
 last_game_id = 0
@@ -102,6 +103,7 @@ class CrawlProcessHandlerBase(object):
 
         self.end_callback = None
         self._receivers = set()
+        self._deflate_group = DeflateGroup()
         self.last_activity_time = time.time()
         self.idle_checker = PeriodicCallback(self.check_idle, 10000,
                                              io_loop = self.io_loop)
@@ -250,6 +252,7 @@ class CrawlProcessHandlerBase(object):
                                      message = self.exit_message,
                                      dump = self.exit_dump_url)
                 watcher.go_lobby()
+            self._deflate_group.remove(watcher)
 
         if self.end_callback:
             self.end_callback()
@@ -417,10 +420,13 @@ class CrawlProcessHandlerBase(object):
             if watcher.watched_game == self:
                 watcher.send_json_options(self.game_params["id"], self.username)
         self._receivers.add(watcher)
+        if watcher.deflate:
+            self._deflate_group.add(watcher)
         self.update_watcher_description()
 
     def remove_watcher(self, watcher):
         self._receivers.remove(watcher)
+        self._deflate_group.remove(watcher)
         self.update_watcher_description()
 
     def watcher_count(self):
@@ -918,6 +924,9 @@ class CrawlProcessHandler(CrawlProcessHandlerBase):
                     self.exit_message = msgobj["message"]
                 else:
                     self.exit_message = None
+            elif msgobj["msg"] == "stats":
+                self.logger.info("Webtiles message stats: %s",
+                                 json_encode(msgobj["types"]))
             else:
                 self.logger.warning("Unknown message from the crawl process: %s",
                                     msgobj["msg"])
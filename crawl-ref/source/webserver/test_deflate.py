@@ -0,0 +1,83 @@
+"""Tests for DeflateGroup; run with python -m unittest test_deflate."""
+
+import random
+import unittest
+import zlib
+
+from deflate import DeflateGroup
+
+class FakeSocket(object):
+    def __init__(self):
+        self.deflate_group = None
+        self.deflate_seq = None
+        self._decompressobj = zlib.decompressobj(-zlib.MAX_WBITS)
+        self.received = []
+
+    def send(self, msg):
+        frame = self.deflate_group.compress(self, msg)
+        self.received.append(
+            self._decompressobj.decompress(frame + b"\x00\x00\xff\xff"))
+
+class DeflateGroupTest(unittest.TestCase):
+    def setUp(self):
+        self.group = DeflateGroup()
+        self.sockets = [FakeSocket() for i in range(5)]
+        for s in self.sockets:
+            self.group.add(s)
+        self.count = 0
+
+    def broadcast(self, sockets=None):
+        self.count += 1
+        msg = b'{"msgs":[{"msg":"map","turn":%d,"cells":"%s"}]}' % (
+                self.count, b"abcdefgh" * (self.count % 7))
+        start = self.group.seq
+        for s in sockets or self.sockets:
+            s.send(msg)
+            self.assertEqual(s.received[-1], msg)
+        return self.group.seq - start
+
+    def assert_rejoins(self, private):
+        for i in range(3):
+            self.broadcast()
+        private.send(b'{"msgs":[{"msg":"options"}]}')
+        compressions = [self.broadcast() for i in range(20)]
+        # Back in sync after one resync frame, then one frame per broadcast
+        self.assertLessEqual(sum(compressions[:2]), 3)
+        self.assertEqual(compressions[2:], [1] * 18)
+        self.assertFalse(self.group.last_resync)
+
+    def test_out_of_sync_socket_first(self):
+        self.assert_rejoins(self.sockets[0])
+
+    def test_out_of_sync_socket_last(self):
+        self.assert_rejoins(self.sockets[-1])
+
+    def test_joining_socket_first(self):
+        for i in range(3):
+            self.broadcast()
+        joining = FakeSocket()
+        self.group.add(joining)
+        self.sockets.insert(0, joining)
+        self.assertEqual(self.broadcast(), 1)
+        self.assertEqual(self.broadcast(), 1)
+        self.assertFalse(self.group.last_resync)
+
+    def test_random_order(self):
+        rand = random.Random(1)
+        for i in range(500):
+            if rand.random() < 0.1:
+                rand.choice(self.sockets).send(b'{"msgs":[]}')
+            elif rand.random() < 0.05:
+                s = FakeSocket()
+                self.group.add(s)
+                self.sockets.append(s)
+            elif rand.random() < 0.05 and len(self.sockets) > 1:
+                self.group.remove(self.sockets.pop(rand.randrange(
+                                                      len(self.sockets))))
+            else:
+                order = list(self.sockets)
+                rand.shuffle(order)
+                self.broadcast(order)
+
+if __name__ == "__main__":
+    unittest.main()
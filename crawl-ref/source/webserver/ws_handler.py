@@ -16,6 +16,7 @@ import config
 import checkoutput
 import userdb
 from util import *
+from deflate import DeflateGroup, new_compressobj
 
 sockets = set()
 current_id = 0
@@ -126,9 +127,13 @@ class CrawlWebSocket(tornado.websocket.WebSocketHandler):
         current_id += 1
 
         self.deflate = True
-        self._compressobj = zlib.compressobj(zlib.Z_DEFAULT_COMPRESSION,
-                                             zlib.DEFLATED,
-                                             -zlib.MAX_WBITS)
+        self._compressobj = new_compressobj()
+        # Set while watching or playing a game; see DeflateGroup
+        self.deflate_group = None
+        self.deflate_seq = None
+        # Whether the client has been sent frames that _compressobj
+        # doesn't know about
+        self.deflate_diverged = False
         self.total_message_bytes = 0
         self.compressed_bytes_sent = 0
         self.uncompressed_bytes_sent = 0
@@ -650,9 +655,7 @@ class CrawlWebSocket(tornado.websocket.WebSocketHandler):
                 # Compress like in deflate-frame extension:
                 # Apply deflate, flush, then remove the 00 00 FF FF
                 # at the end
-                compressed = self._compressobj.compress(msg)
-                compressed += self._compressobj.flush(zlib.Z_SYNC_FLUSH)
-                compressed = compressed[:-4]
+                compressed = self._compress(msg)
                 self.compressed_bytes_sent += len(compressed)
                 super(CrawlWebSocket, self).write_message(compressed, binary=True)
             else:
@@ -663,6 +666,20 @@ class CrawlWebSocket(tornado.websocket.WebSocketHandler):
             if self.ws_connection != None:
                 self.ws_connection._abort()
 
+    def _compress(self, msg):
+        if self.deflate_group:
+            self.deflate_diverged = True
+            return self.deflate_group.compress(self, msg)
+
+        compressed = ""
+        if self.deflate_diverged:
+            # Forget what the client hasn't seen from us
+            compressed = self._compressobj.flush(zlib.Z_FULL_FLUSH)
+            self.deflate_diverged = False
+        compressed += self._compressobj.compress(msg)
+        compressed += self._compressobj.flush(zlib.Z_SYNC_FLUSH)
+        return compressed[:-4]
+
     def write_message(self, msg, send=True):
         if self.client_closed: return
         self.message_queue.append(utf8(msg))